@@ -0,0 +1,272 @@
+// Micro-benchmarks of the hot paths over seeded scenarios, in the manner of
+// Google Benchmark, so a regression shows up as a number.
+//
+//   BenchSuite [--filter TEXT] [--min-time S] [--repetitions R]
+//              [--json FILE] [--compare FILE]
+//
+// Every scenario is a square map of 128, 512 or 2048 cells a side with 5,
+// 10 or 25% random fires, all seeded, so two runs see the same maps and the
+// same queries. A benchmark runs its operation until at least S seconds
+// (default 0.2) have been spent in it, R times (default 3), and reports the
+// median time per operation over the repetitions and the 99th percentile
+// of single operations. Setup work (copying a map before a spread, say) is
+// not timed. --json writes the results; --compare reads an earlier --json
+// file and prints the change for each benchmark. Names look like
+// "path.astar/512/10" and --filter keeps those containing TEXT.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <ctime>
+
+#include "GridMap.h"
+#include "Mission.h"
+#include "Pathfinding.h"
+#include "Hpa.h"
+#include "Rng.h"
+#include "ThreadPool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> op;           // what is timed
+    std::function<void()> prepare;      // run untimed before each op, may be empty
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double nsPerOp = 0;                 // median over the repetitions
+    double p99Ns = 0;                   // of single operations, all repetitions
+};
+
+// A seeded scenario: the map and some queries across it
+struct Scenario {
+    int size;
+    int density;
+    GridMap map;
+    std::vector<std::pair<std::pair<int,int>, std::pair<int,int>>> legs;
+
+    Scenario(int size, int density) : size(size), density(density), map(size, size) {
+        map.setSeed(1000u * size + density);
+        map.populateRandomFires(density);
+        // Legs of at least half the map, between clear cells
+        Xoshiro256 rng(1000u * size + density);
+        while (legs.size() < 32) {
+            int sr = rng.below(size), sc = rng.below(size), gr = rng.below(size), gc = rng.below(size);
+            if (map.isFire(sr, sc) || map.isFire(gr, gc)) continue;
+            if (std::max(std::abs(sr - gr), std::abs(sc - gc)) < size / 2) continue;
+            legs.push_back({{sr, sc}, {gr, gc}});
+        }
+    }
+    std::string tag() const { return "/" + std::to_string(size) + "/" + std::to_string(density); }
+};
+
+Result run(const Benchmark& b, double minSeconds, int repetitions) {
+    Result r;
+    r.name = b.name;
+    std::vector<double> perOp;
+    std::vector<uint64_t> samples;
+    for (int rep = 0; rep < repetitions; rep++) {
+        uint64_t spent = 0, count = 0;
+        uint64_t budget = (uint64_t)(minSeconds * 1e9);
+        while (spent < budget) {
+            if (b.prepare) b.prepare();
+            auto start = Clock::now();
+            b.op();
+            uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            spent += ns;
+            count++;
+            samples.push_back(ns);
+        }
+        perOp.push_back((double)spent / count);
+        r.iterations += count;
+    }
+    std::sort(perOp.begin(), perOp.end());
+    r.nsPerOp = perOp[perOp.size() / 2];
+    size_t at = std::min(samples.size() - 1, (size_t)(samples.size() * 0.99));
+    std::nth_element(samples.begin(), samples.begin() + at, samples.end());
+    r.p99Ns = (double)samples[at];
+    return r;
+}
+
+std::string formatTime(double ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(ns < 1e4 ? 0 : 1);
+    if (ns < 1e4) out << ns << " ns";
+    else if (ns < 1e7) out << ns / 1e3 << " us";
+    else out << ns / 1e6 << " ms";
+    return out.str();
+}
+
+// name -> ns per operation from an earlier --json file
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\":\"");
+        size_t time = line.find("\"real_time\":");
+        if (name == std::string::npos || time == std::string::npos) continue;
+        name += 8;
+        baseline[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + time + 12);
+    }
+    return baseline;
+}
+
+void writeJson(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    out << "{\n  \"context\": {\"date\":\"" << date << "\",\"num_cpus\":"
+        << std::thread::hardware_concurrency() << "},\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        // One benchmark per line, which readBaseline() relies on
+        out << "    {\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations
+            << ",\"real_time\":" << std::fixed << std::setprecision(1) << r.nsPerOp
+            << ",\"p99_time\":" << r.p99Ns << ",\"time_unit\":\"ns\"}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string filter, jsonPath, comparePath;
+    double minSeconds = 0.2;
+    int repetitions = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) minSeconds = std::atof(argv[++i]);
+        else if (arg == "--repetitions" && i + 1 < argc) repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc) comparePath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--filter TEXT] [--min-time S] [--repetitions R]"
+                      << " [--json FILE] [--compare FILE]\n";
+            return 1;
+        }
+    }
+    std::map<std::string, double> baseline;
+    if (!comparePath.empty()) baseline = readBaseline(comparePath);
+
+    std::cout << std::left << std::setw(30) << "Benchmark" << std::right << std::setw(12) << "Time"
+              << std::setw(12) << "p99" << std::setw(12) << "Iterations";
+    if (!baseline.empty()) std::cout << std::setw(10) << "Change";
+    std::cout << "\n" << std::string(baseline.empty() ? 66 : 76, '-') << "\n";
+
+    ThreadPool pool(1);
+    std::vector<Result> results;
+    for (int size : {128, 512, 2048}) {
+        for (int density : {5, 10, 25}) {
+            Scenario s(size, density);
+            std::string tag = s.tag();
+            std::vector<Benchmark> benchmarks;
+            std::vector<std::pair<int,int>> path;
+            size_t leg = 0;
+            auto nextLeg = [&]() -> const std::pair<std::pair<int,int>, std::pair<int,int>>& {
+                return s.legs[leg++ % s.legs.size()];
+            };
+
+            PathWorkspace bfsWs;
+            benchmarks.push_back({"path.bfs" + tag, [&]() {
+                auto& l = nextLeg();
+                getPathBFS(s.map, bfsWs, l.first.first, l.first.second, l.second.first, l.second.second, path);
+            }, nullptr});
+            AStarPlanner astar;
+            benchmarks.push_back({"path.astar" + tag, [&]() {
+                auto& l = nextLeg();
+                astar.findPath(s.map, l.first.first, l.first.second, l.second.first, l.second.second, path);
+            }, nullptr});
+            JpsPlanner jps;
+            benchmarks.push_back({"path.jps" + tag, [&]() {
+                auto& l = nextLeg();
+                jps.findPath(s.map, l.first.first, l.first.second, l.second.first, l.second.second, path);
+            }, nullptr});
+            // Built clusters: the steady state between spreads
+            std::unique_ptr<HpaPlanner> hpa;
+            benchmarks.push_back({"path.hpa" + tag, [&]() {
+                auto& l = nextLeg();
+                hpa->findPath(s.map, l.first.first, l.first.second, l.second.first, l.second.second, path);
+            }, [&]() {
+                if (hpa) return;
+                hpa = std::make_unique<HpaPlanner>();
+                hpa->build(s.map, pool);
+            }});
+
+            // Everything discovered but the last row: a flood of the map
+            DiscoveredLayer discovered;
+            discovered.reset(size, size);
+            for (int r = 0; r < size - 1; r++) discovered.markSpan(r, 0, size - 1);
+            PathWorkspace reachWs;
+            benchmarks.push_back({"path.anyReachable" + tag, [&]() {
+                auto& l = nextLeg();
+                anyReachableUndiscovered(s.map, discovered, reachWs, l.first.first, l.first.second);
+            }, nullptr});
+
+            // One spread step from the scenario's map each time
+            GridMap burning(1, 1);
+            benchmarks.push_back({"map.spread" + tag, [&]() {
+                burning.spreadFires(0.02);
+            }, [&]() {
+                burning = s.map;
+            }});
+
+            // A whole frontier mission, spreading as it flies
+            GridMap flown(1, 1);
+            if (size <= 512) {
+                benchmarks.push_back({"mission.frontier" + tag, [&]() {
+                    MissionConfig config;
+                    Mission mission(flown, config);
+                    mission.run(s.legs[0].first.first, s.legs[0].first.second);
+                }, [&]() {
+                    flown = s.map;
+                }});
+                // The same with a long line-of-sight sensor
+                benchmarks.push_back({"mission.los20" + tag, [&]() {
+                    MissionConfig config;
+                    config.sensor = SensorShape::LineOfSight;
+                    config.perceptionRange = 20;
+                    Mission mission(flown, config);
+                    mission.run(s.legs[0].first.first, s.legs[0].first.second);
+                }, [&]() {
+                    flown = s.map;
+                }});
+            }
+
+            for (const Benchmark& b : benchmarks) {
+                if (!filter.empty() && b.name.find(filter) == std::string::npos) continue;
+                Result r = run(b, minSeconds, repetitions);
+                std::cout << std::left << std::setw(30) << r.name << std::right
+                          << std::setw(12) << formatTime(r.nsPerOp) << std::setw(12) << formatTime(r.p99Ns)
+                          << std::setw(12) << r.iterations;
+                auto it = baseline.find(r.name);
+                if (it != baseline.end() && it->second > 0) {
+                    std::cout << std::setw(9) << std::showpos << std::fixed << std::setprecision(1)
+                              << (r.nsPerOp / it->second - 1) * 100 << std::noshowpos << "%";
+                }
+                std::cout << std::endl;
+                results.push_back(r);
+            }
+        }
+    }
+    if (!jsonPath.empty()) writeJson(jsonPath, results);
+    return 0;
+}
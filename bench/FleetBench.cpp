@@ -0,0 +1,97 @@
+// Flies fleets of K drones over the same map and reports the time to full
+// coverage against K and against the number of planning threads.
+//
+//   FleetBench [--spread p] [--drones 1,2,4,...] [--threads 1,2,...] [size]
+//
+// The map is square (default 500), 10% random fires, seeded; every drone
+// takes off from the same cell in the top row. Ticks are simulated time
+// (one move per drone per tick); the wall-clock columns are what the
+// simulation costs on this machine.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "GridMap.h"
+#include "Fleet.h"
+#include "ThreadPool.h"
+
+namespace {
+
+std::vector<int> parseList(const std::string& text)
+{
+    std::vector<int> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (std::atoi(item.c_str()) > 0) values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+void runOne(int size, int drones, int threads, double spread)
+{
+    GridMap map(size, size);
+    map.setSeed(1);
+    map.populateRandomFires(10);
+    int startCol = 0;
+    while (startCol < size && map.isFire(0, startCol)) startCol++;
+
+    FleetConfig config;
+    config.spreadChance = spread;
+    config.spreadEvery = spread > 0 ? 5 : 0;
+    ThreadPool pool(threads);
+    Fleet fleet(map, config, pool);
+
+    auto begin = std::chrono::steady_clock::now();
+    bool complete = fleet.run(std::vector<std::pair<int,int>>(drones, {0, startCol}));
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    const Fleet::Stats& s = fleet.getStats();
+    std::cout << std::setw(5) << size << std::setw(7) << drones << std::setw(8) << threads
+              << std::setw(10) << s.coverageTicks
+              << std::setw(10) << s.moves
+              << std::setw(10) << s.decisions
+              << std::setw(6) << s.rebalances
+              << std::setw(11) << std::fixed << std::setprecision(1) << s.planNanos / 1e6
+              << std::setw(11) << s.planWallNanos / 1e6
+              << std::setw(11) << totalMs
+              << std::setw(8) << fleet.getUndiscovered()
+              << "  " << (complete ? "done" : "signal lost") << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int size = 500;
+    double spread = 0.0;
+    std::vector<int> drones = {1, 2, 4, 8, 16};
+    int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threads = {1};
+    if (cores > 1) threads.push_back(cores);
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--spread" && i + 1 < argc) {
+            spread = std::atof(argv[++i]);
+        } else if (arg == "--drones" && i + 1 < argc) {
+            drones = parseList(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = parseList(argv[++i]);
+        } else {
+            size = std::atoi(arg.c_str());
+        }
+    }
+
+    std::cout << "map  drones threads  coverage     moves  searches  rebal  plan (ms)  plan wall  total (ms)  unseen\n";
+    for (int k : drones) {
+        for (int t : threads) {
+            runOne(size, k, t, spread);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+// Query latency of the hierarchical planner against flat A* on large maps.
+//
+//   HpaBench [--queries N] [--no-flat] [--threads T] [--spread P] [--cluster C] [size ...]
+//
+// Each map is square (default 4096 and 16384), 10% random fires, seeded.
+// The queries are the same for both planners: N (default 10) pairs of
+// clear cells at least half the map apart. HPA* is timed cold (clusters
+// built as the searches reach them), after build() has built every
+// cluster on T threads (default: the hardware's), and again after a fire
+// spread (chance P, default 0.001) has invalidated the clusters it touched. "cost" is the HPA* path cost over
+// the flat A* one. C is the cluster size (default 64). --no-flat skips flat A*, whose workspace needs about
+// 12 bytes per cell.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+#include "GridMap.h"
+#include "Pathfinding.h"
+#include "Hpa.h"
+#include "Rng.h"
+#include "ThreadPool.h"
+
+namespace {
+
+struct Query {
+    int fromR, fromC, toR, toC;
+};
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// True if every step is to a neighbouring clear cell and the ends match
+bool validPath(const GridMap& map, const Query& q, const std::vector<std::pair<int,int>>& path)
+{
+    if (path.empty() || path.front() != std::make_pair(q.fromR, q.fromC) ||
+        path.back() != std::make_pair(q.toR, q.toC)) {
+        return false;
+    }
+    for (size_t i = 0; i < path.size(); i++) {
+        if (map.isFire(path[i].first, path[i].second)) return false;
+        if (i > 0 && (std::abs(path[i].first - path[i - 1].first) > 1 ||
+                      std::abs(path[i].second - path[i - 1].second) > 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs every query; returns the mean ms, keeps the path costs and counts
+// the paths that are not valid
+double runQueries(PathPlanner& planner, const GridMap& map, const std::vector<Query>& queries,
+                  std::vector<uint32_t>& costs, int& invalid, double& worst)
+{
+    std::vector<std::pair<int,int>> path;
+    costs.clear();
+    invalid = 0;
+    worst = 0;
+    double total = 0;
+    for (const Query& q : queries) {
+        auto start = std::chrono::steady_clock::now();
+        planner.findPath(map, q.fromR, q.fromC, q.toR, q.toC, path);
+        double ms = msSince(start);
+        total += ms;
+        worst = std::max(worst, ms);
+        costs.push_back(pathCost(path));
+        if (!validPath(map, q, path)) invalid++;
+    }
+    return queries.empty() ? 0 : total / queries.size();
+}
+
+double costRatio(const std::vector<uint32_t>& hpa, const std::vector<uint32_t>& flat)
+{
+    double sum = 0;
+    int n = 0;
+    for (size_t i = 0; i < hpa.size() && i < flat.size(); i++) {
+        if (flat[i] == 0) continue;
+        sum += (double)hpa[i] / flat[i];
+        n++;
+    }
+    return n ? sum / n : 0;
+}
+
+void printRow(const char* name, double mean, double worst, double ratio, int invalid)
+{
+    std::cout << "  " << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << mean << std::setw(10) << worst;
+    if (ratio > 0) std::cout << std::setw(8) << ratio;
+    else std::cout << std::setw(8) << "-";
+    std::cout << std::setw(8) << invalid << "\n";
+}
+
+void runOne(int size, int count, bool withFlat, int threads, double spread, int cluster)
+{
+    auto start = std::chrono::steady_clock::now();
+    GridMap map(size, size);
+    map.setSeed(1);
+    map.populateRandomFires(10);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Map " << size << " x " << size << " (generated in " << msSince(start) / 1000 << " s)\n";
+
+    std::vector<Query> queries;
+    Xoshiro256 rng(1);
+    while ((int)queries.size() < count) {
+        Query q{(int)rng.below(size), (int)rng.below(size), (int)rng.below(size), (int)rng.below(size)};
+        if (map.isFire(q.fromR, q.fromC) || map.isFire(q.toR, q.toC)) continue;
+        if (std::max(std::abs(q.fromR - q.toR), std::abs(q.fromC - q.toC)) < size / 2) continue;
+        queries.push_back(q);
+    }
+
+    std::cout << "  " << std::left << std::setw(16) << "planner" << std::right
+              << std::setw(10) << "mean ms" << std::setw(10) << "max ms"
+              << std::setw(8) << "cost" << std::setw(8) << "invalid" << "\n";
+    std::vector<uint32_t> flatCosts, costs;
+    int invalid = 0;
+    double worst = 0;
+    if (withFlat) {
+        AStarPlanner flat;
+        double mean = runQueries(flat, map, queries, flatCosts, invalid, worst);
+        printRow("flat A*", mean, worst, 0, invalid);
+    }
+
+    double mean;
+    {
+        HpaPlanner cold(cluster);
+        mean = runQueries(cold, map, queries, costs, invalid, worst);
+        printRow("HPA* cold", mean, worst, costRatio(costs, flatCosts), invalid);
+    }
+
+    HpaPlanner hpa(cluster);
+    ThreadPool pool(threads);
+    start = std::chrono::steady_clock::now();
+    hpa.build(map, pool);
+    double buildMs = msSince(start);
+    size_t entrances = hpa.entranceCount(), edges = hpa.edgeCount();
+    mean = runQueries(hpa, map, queries, costs, invalid, worst);
+    printRow("HPA* built", mean, worst, costRatio(costs, flatCosts), invalid);
+
+    // A spread, then the same queries on the changed map
+    start = std::chrono::steady_clock::now();
+    map.spreadFires(spread);
+    hpa.cellsBlocked(map.getLastIgnited());
+    double spreadMs = msSince(start);
+    uint64_t builds = hpa.getHpaStats().builds;
+    // Fires may have reached the ends of some queries
+    queries.erase(std::remove_if(queries.begin(), queries.end(), [&](const Query& q) {
+        return map.isFire(q.fromR, q.fromC) || map.isFire(q.toR, q.toC);
+    }), queries.end());
+    mean = runQueries(hpa, map, queries, costs, invalid, worst);
+    printRow("HPA* after fire", mean, worst, 0, invalid);
+
+    std::cout << "  build(): " << buildMs << " ms on " << pool.size() << " thread(s), "
+              << entrances << " entrances, " << edges << " edges\n"
+              << "  spread: " << map.getLastIgnited().size() << " cells ignited, "
+              << hpa.getHpaStats().invalidations << " of " << hpa.clusterCount() << " clusters invalidated in " << spreadMs
+              << " ms, " << hpa.getHpaStats().builds - builds << " rebuilt by the queries\n"
+              << "  fallbacks to flat A*: " << hpa.getHpaStats().fallbacks << "\n\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int count = 10;
+    bool withFlat = true;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    double spread = 0.001;
+    int cluster = 64;
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--queries" && i + 1 < argc) count = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--no-flat") withFlat = false;
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--spread" && i + 1 < argc) spread = std::atof(argv[++i]);
+        else if (arg == "--cluster" && i + 1 < argc) cluster = std::max(8, std::atoi(argv[++i]));
+        else if (std::atoi(argv[i]) > 0) sizes.push_back(std::atoi(argv[i]));
+    }
+    if (sizes.empty()) sizes = {4096, 16384};
+    for (int size : sizes) runOne(size, count, withFlat, threads, spread, cluster);
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Plans across a map file far larger than a GridMap could hold and reports
+// how much of it had to be in memory.
+//
+//   MapFileBench [--file PATH] [--keep] [--weight W] [size]
+//
+// Writes a size x size random map file (default 100000, 10% fires, seeded)
+// unless PATH already holds one of that size, then flies long A* legs
+// across it with MapFilePlanner (heuristic weight W, default 1.1) and loads
+// a 1024 x 1024 GridMap window. After every query it prints how much of the
+// file the process had in memory and its whole resident set, then drops the
+// mapped pages again. "cost" is the path cost over the straight-line octile
+// distance. The file is deleted at the end unless --keep is given.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "GridMap.h"
+#include "MapFile.h"
+#include "Pathfinding.h"
+
+namespace {
+
+// A resident-set line of /proc/self/status ("VmRSS:", "RssFile:"), in
+// bytes; 0 where /proc is missing
+size_t processResident(const std::string& field = "VmRSS:")
+{
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == field) {
+            size_t kb = 0;
+            status >> kb;
+            return kb * 1024;
+        }
+        status.ignore(1 << 12, '\n');
+    }
+    return 0;
+}
+
+// Evicts the file from the page cache, as if it had never been read: a
+// map larger than memory is on disk, not cached
+void dropCache(const std::string& path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#endif
+}
+
+double megabytes(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// First cell at or right of (r, c) that is not on fire
+std::pair<int,int> clearCell(const MapFile& file, int r, int c)
+{
+    while (c < file.getCols() - 1 && file.isFire(r, c)) c++;
+    return {r, c};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string mapPath = "MapFileBench.map";
+    bool keep = false;
+    int size = 100000;
+    double weight = 1.1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--file" && i + 1 < argc) mapPath = argv[++i];
+        else if (arg == "--keep") keep = true;
+        else if (arg == "--weight" && i + 1 < argc) weight = std::atof(argv[++i]);
+        else size = std::atoi(argv[i]);
+    }
+
+    MapFile file;
+    std::string error;
+    if (!file.open(mapPath, error) || file.getRows() != size || file.getCols() != size) {
+        file.close();
+        std::cout << "Writing a " << size << " x " << size << " map to " << mapPath << "...\n";
+        auto start = std::chrono::steady_clock::now();
+        if (!writeRandomMapFile(mapPath, size, size, 10, 1, error) || !file.open(mapPath, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cout << "  written in " << std::fixed << std::setprecision(1) << msSince(start) / 1000
+                  << " s, " << megabytes(size_t(MAP_FILE_HEADER) + size_t((size + 63) / 64) * ((size + 63) / 64) * 512)
+                  << " MB\n";
+    }
+    file.releasePages();
+    dropCache(mapPath);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Map " << file.getRows() << " x " << file.getCols()
+              << ", process resident " << megabytes(processResident()) << " MB\n\n";
+
+    int last = size - 1;
+    struct Leg {
+        const char* name;
+        std::pair<int,int> from, to;
+    };
+    std::vector<Leg> legs = {
+        {"short leg", clearCell(file, size / 2, size / 2), clearCell(file, size / 2 + 700, size / 2 + 1000)},
+        {"across", clearCell(file, size / 2, 0), clearCell(file, size / 2, last - 64)},
+        {"down", clearCell(file, 0, size / 3), clearCell(file, last, size / 3)},
+        {"diagonal", clearCell(file, 0, 0), clearCell(file, last, last - 64)},
+    };
+
+    std::cout << std::setw(10) << "query" << std::setw(10) << "ms" << std::setw(10) << "moves"
+              << std::setw(8) << "cost" << std::setw(11) << "expanded" << std::setw(10) << "state MB"
+              << std::setw(10) << "file MB" << std::setw(10) << "RSS MB" << "\n";
+    MapFilePlanner planner;
+    planner.setWeight(weight);
+    std::vector<std::pair<int,int>> path;
+    for (const Leg& leg : legs) {
+        uint64_t before = planner.getStats().expanded;
+        auto start = std::chrono::steady_clock::now();
+        planner.findPath(file, leg.from.first, leg.from.second, leg.to.first, leg.to.second, path);
+        double ms = msSince(start);
+        std::cout << std::setw(10) << leg.name << std::setw(10) << ms
+                  << std::setw(10) << (path.empty() ? 0 : path.size() - 1)
+                  << std::setw(8) << (double)pathCost(path) / pathCost({leg.from, leg.to})
+                  << std::setw(11) << planner.getStats().expanded - before
+                  << std::setw(10) << megabytes(planner.stateBytes())
+                  << std::setw(10) << megabytes(processResident("RssFile:"))
+                  << std::setw(10) << megabytes(processResident()) << "\n";
+        file.releasePages();
+        dropCache(mapPath);
+    }
+
+    // A drone's working map: a window of the file as a GridMap
+    GridMap window(1024, 1024);
+    auto start = std::chrono::steady_clock::now();
+    window.loadFires(file, size / 2 - 512, size / 2 - 500);
+    double ms = msSince(start);
+    std::cout << std::setw(10) << "window" << std::setw(10) << ms
+              << std::setw(10) << "-" << std::setw(8) << "-" << std::setw(11) << "-" << std::setw(10) << "-"
+              << std::setw(10) << megabytes(processResident("RssFile:"))
+              << std::setw(10) << megabytes(processResident()) << "\n";
+
+    file.close();
+    if (!keep) std::remove(mapPath.c_str());
+    return 0;
+}
@@ -0,0 +1,390 @@
+// Checks that the fast paths give the same answers as the plain ones they
+// replaced, on seeded maps:
+//  - fire spread: dense, sparse, auto and the parallel sweep, with cells
+//    set and cleared between steps
+//  - D* Lite against a fresh A* search as the drone moves and fires spread
+//  - ConnectivityIndex against a BFS flood (anyReachableUndiscovered and
+//    getPathBFS) as cells are discovered and burn
+//  - HPA* paths: valid, found exactly when A* finds one, and no more than
+//    --hpa-bound (default 1.5) times the A* cost. Legs just past the flat
+//    A* cutoff can detour through an entrance by a third; the bound is
+//    there to catch a broken graph, not to grade the detours.
+//  - batch runs: the same missions on one thread and on several, and the
+//    last one flown again alone on a fresh map, for each sweep planner
+//  - fleets: the same flight, fires and per-drone counts on one thread and
+//    on several
+//
+//   SelfCheck [--seeds N] [--seed S] [--hpa-bound B]
+//
+// Runs N seeds (default 20) from S (default 1). Prints one line per check
+// and exits with 1 if any failed; `make check` builds and runs it.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "GridMap.h"
+#include "Pathfinding.h"
+#include "DStarLite.h"
+#include "Connectivity.h"
+#include "Coverage.h"
+#include "Hpa.h"
+#include "Mission.h"
+#include "Batch.h"
+#include "Fleet.h"
+#include "Rng.h"
+#include "ThreadPool.h"
+
+namespace {
+
+typedef std::vector<std::pair<int,int>> Path;
+
+// Tallies one check; the first failure is kept so it can be rerun
+struct Check {
+    explicit Check(const char* name) : name(name) {}
+
+    const char* name;
+    uint64_t cases = 0;
+    uint64_t failures = 0;
+    std::string first;
+
+    void expect(bool ok, uint64_t seed, const std::string& what) {
+        cases++;
+        if (ok) return;
+        if (failures++ == 0) first = "seed " + std::to_string(seed) + ": " + what;
+    }
+    bool report(const std::string& extra = "") const {
+        std::cout << std::left << std::setw(14) << name << std::right
+                  << std::setw(9) << cases << " cases  ";
+        if (failures == 0) std::cout << "ok" << extra << "\n";
+        else std::cout << failures << " FAILED, first at " << first << "\n";
+        return failures == 0;
+    }
+};
+
+std::string cellName(int r, int c)
+{
+    return "(" + std::to_string(r) + "," + std::to_string(c) + ")";
+}
+
+// A random clear cell, or false if none turned up
+bool randomClear(const GridMap& map, Xoshiro256& rng, int& r, int& c)
+{
+    for (int tries = 0; tries < 1000; tries++) {
+        r = (int)rng.below(map.getRows());
+        c = (int)rng.below(map.getCols());
+        if (!map.isFire(r, c)) return true;
+    }
+    return false;
+}
+
+// True if every step is to a neighbouring clear cell and the ends match
+bool validPath(const GridMap& map, int fromR, int fromC, int toR, int toC, const Path& path)
+{
+    if (path.empty() || path.front() != std::make_pair(fromR, fromC) ||
+        path.back() != std::make_pair(toR, toC)) {
+        return false;
+    }
+    for (size_t i = 0; i < path.size(); i++) {
+        if (map.isFire(path[i].first, path[i].second)) return false;
+        if (i > 0 && (std::abs(path[i].first - path[i - 1].first) > 1 ||
+                      std::abs(path[i].second - path[i - 1].second) > 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameFires(const GridMap& a, const GridMap& b)
+{
+    int words = a.getWordsPerRow();
+    for (int r = 0; r < a.getRows(); r++) {
+        if (!std::equal(a.fireRow(r), a.fireRow(r) + words, b.fireRow(r))) return false;
+    }
+    return true;
+}
+
+// Every spread mode against the dense sweep, step by step, and a map that
+// switches from dense to sparse after it is filled. The columns are not a
+// multiple of 64, so the padding bits are exercised too.
+void checkSpread(Check& check, uint64_t seed, ThreadPool& pool)
+{
+    const int rows = 150, cols = 263;
+    const SpreadMode modes[] = {SpreadMode::Dense, SpreadMode::Sparse, SpreadMode::Auto, SpreadMode::Dense};
+    std::vector<GridMap> maps;
+    for (SpreadMode mode : modes) {
+        maps.emplace_back(rows, cols);
+        maps.back().setSpreadMode(mode);
+        maps.back().setSeed(seed);
+        maps.back().populateRandomFires(3);
+    }
+    // Filled while dense, so the sparse path starts from no front at all
+    maps.emplace_back(rows, cols);
+    maps.back().setSeed(seed);
+    maps.back().setSpreadMode(SpreadMode::Dense);
+    maps.back().populateRandomFires(3);
+    maps.back().setSpreadMode(SpreadMode::Sparse);
+    Xoshiro256 rng(counterHash(seed, 1));
+    for (int step = 0; step < 60; step++) {
+        // Edits outside spreadFires: a few fires lit and a few put out
+        if (step % 5 == 0) {
+            for (int k = 0; k < 20; k++) {
+                int r = (int)rng.below(rows), c = (int)rng.below(cols);
+                char value = k % 4 ? 'X' : ' ';
+                for (GridMap& map : maps) map.setCell(r, c, value);
+            }
+        }
+        for (size_t m = 0; m < maps.size(); m++) {
+            if (m == 3) maps[m].spreadFires(0.05, pool);
+            else maps[m].spreadFires(0.05);
+        }
+        for (size_t m = 1; m < maps.size(); m++) {
+            check.expect(sameFires(maps[0], maps[m]) &&
+                         maps[0].getLastIgnited() == maps[m].getLastIgnited(),
+                         seed, "mode " + std::to_string(m) + " differs after step " + std::to_string(step));
+        }
+    }
+}
+
+// D* Lite repairs its search as the drone moves and fires spread; each
+// path must cost what a fresh A* search from the same cell costs
+void checkDStar(Check& check, uint64_t seed)
+{
+    const int size = 120;
+    GridMap map(size, size);
+    map.setSeed(seed);
+    map.populateRandomFires(10);
+    Xoshiro256 rng(counterHash(seed, 2));
+    DStarLite dstar;
+    AStarPlanner astar;
+    Path dpath, apath;
+    for (int leg = 0; leg < 5; leg++) {
+        int r, c, goalR, goalC;
+        if (!randomClear(map, rng, r, c) || !randomClear(map, rng, goalR, goalC)) return;
+        dstar.reset(map, r, c, goalR, goalC);
+        for (int round = 0; round < 40; round++) {
+            dstar.computePath(dpath);
+            astar.findPath(map, r, c, goalR, goalC, apath);
+            std::string where = "leg " + std::to_string(leg) + " round " + std::to_string(round) +
+                                " from " + cellName(r, c) + " to " + cellName(goalR, goalC);
+            if (apath.empty()) {
+                check.expect(dpath.empty(), seed, where + ": A* finds no path, D* Lite does");
+                break;
+            }
+            check.expect(validPath(map, r, c, goalR, goalC, dpath) && pathCost(dpath) == pathCost(apath),
+                         seed, where + ": D* Lite cost " + std::to_string(pathCost(dpath)) +
+                               ", A* " + std::to_string(pathCost(apath)));
+            if (dpath.size() <= 1) break;
+            // A few moves along the path, then a spread
+            size_t moves = std::min<size_t>(3, dpath.size() - 1);
+            r = dpath[moves].first;
+            c = dpath[moves].second;
+            dstar.moveStart(r, c);
+            map.spreadFires(0.005);
+            dstar.cellsBlocked(map.getLastIgnited());
+            if (map.isFire(r, c) || map.isFire(goalR, goalC)) break;
+        }
+    }
+}
+
+// The index's O(1) answers against flood fills over the same map
+void checkConnectivity(Check& check, uint64_t seed)
+{
+    const int rows = 100, cols = 140;
+    GridMap map(rows, cols);
+    map.setSeed(seed);
+    map.populateRandomFires(30);
+    Xoshiro256 rng(counterHash(seed, 3));
+    ConnectivityIndex index;
+    index.build(map);
+    DiscoveredLayer discovered;
+    discovered.reset(rows, cols);
+    PathWorkspace ws;
+    Path path;
+    for (int round = 0; round < 40; round++) {
+        for (int k = 0; k < 300; k++) {
+            int r = (int)rng.below(rows), c = (int)rng.below(cols);
+            index.markDiscovered(r, c);
+            discovered.markSpan(r, c, c);
+        }
+        for (int k = 0; k < 40; k++) {
+            int r, c, toR, toC;
+            if (!randomClear(map, rng, r, c) || !randomClear(map, rng, toR, toC)) return;
+            std::string at = "round " + std::to_string(round) + " at " + cellName(r, c);
+            check.expect(index.reachableUndiscovered(r, c) ==
+                         anyReachableUndiscovered(map, discovered, ws, r, c),
+                         seed, at + ": reachableUndiscovered differs from BFS");
+            getPathBFS(map, ws, r, c, toR, toC, path);
+            check.expect(index.reachable(r, c, toR, toC) == !path.empty(),
+                         seed, at + ": reachable to " + cellName(toR, toC) + " differs from BFS");
+        }
+        map.spreadFires(0.04);
+        index.cellsBlocked(map.getLastIgnited());
+    }
+}
+
+// HPA* with its default clusters on a map of 8x8 of them, before and after fires invalidate some
+// of them. Returns the largest HPA* / A* cost ratio seen.
+double checkHpa(Check& check, uint64_t seed, double bound)
+{
+    const int size = 512;
+    GridMap map(size, size);
+    map.setSeed(seed);
+    map.populateRandomFires(10);
+    Xoshiro256 rng(counterHash(seed, 4));
+    HpaPlanner hpa;
+    AStarPlanner astar;
+    Path hpath, apath;
+    double worst = 1.0;
+    for (int round = 0; round < 3; round++) {
+        for (int q = 0; q < 10; q++) {
+            int r, c, toR, toC;
+            if (!randomClear(map, rng, r, c) || !randomClear(map, rng, toR, toC)) return worst;
+            hpa.findPath(map, r, c, toR, toC, hpath);
+            astar.findPath(map, r, c, toR, toC, apath);
+            std::string what = "round " + std::to_string(round) + " from " + cellName(r, c) +
+                               " to " + cellName(toR, toC);
+            if (apath.empty()) {
+                check.expect(hpath.empty(), seed, what + ": A* finds no path, HPA* does");
+                continue;
+            }
+            double ratio = (double)pathCost(hpath) / std::max(1u, pathCost(apath));
+            if (validPath(map, r, c, toR, toC, hpath)) worst = std::max(worst, ratio);
+            check.expect(validPath(map, r, c, toR, toC, hpath) && ratio >= 1.0 && ratio <= bound,
+                         seed, what + (hpath.empty() ? ": no HPA* path" : ": cost ratio " + std::to_string(ratio)));
+        }
+        map.spreadFires(0.01);
+        hpa.cellsBlocked(map.getLastIgnited());
+    }
+    return worst;
+}
+
+// Arenas fly mission after mission over maps refilled in place, so any
+// state a planner keeps from the last map shows up as a difference
+void checkBatch(Check& check, uint64_t seed)
+{
+    for (const char* planner : {"astar", "hpa"}) {
+        BatchConfig config;
+        config.missions = 4;
+        config.rows = config.cols = 130;
+        config.seed = seed;
+        config.mission.mode = ExploreMode::Sweep;
+        config.mission.planner = planner;
+        config.mission.spreadEvery = 0;
+        config.threads = 1;
+        BatchResult serial = runBatch(config);
+        config.threads = 3;
+        BatchResult parallel = runBatch(config);
+        for (size_t i = 0; i < serial.missions.size(); i++) {
+            const BatchMission& a = serial.missions[i];
+            const BatchMission& b = parallel.missions[i];
+            check.expect(a.steps == b.steps && a.undiscovered == b.undiscovered &&
+                         a.firesFound == b.firesFound && a.lost == b.lost,
+                         seed, std::string(planner) + " mission " + std::to_string(i) +
+                               ": " + std::to_string(a.steps) + " steps on 1 thread, " +
+                               std::to_string(b.steps) + " on 3");
+        }
+
+        // The last mission, which reused an arena, against a fresh one
+        const BatchMission& last = serial.missions.back();
+        GridMap map(config.rows, config.cols);
+        map.setSeed(last.seed);
+        map.populateRandomFires(config.firePercent);
+        Mission mission(map, config.mission);
+        bool lost = map.isFire(last.startRow, last.startCol) || !mission.run(last.startRow, last.startCol);
+        check.expect(lost == last.lost && (lost || (mission.getStats().steps == last.steps &&
+                                                    mission.getUndiscovered() == last.undiscovered)),
+                     seed, std::string(planner) + " last mission: " + std::to_string(last.steps) +
+                           " steps in the batch, " + std::to_string(mission.getStats().steps) + " alone");
+    }
+}
+
+// One fleet flight: what each drone did and the fires in report order
+struct FleetTrace {
+    std::vector<uint64_t> moves, found;
+    std::vector<std::pair<int,int>> fires;
+    uint64_t ticks = 0;
+};
+
+FleetTrace flyFleet(uint64_t seed, int threads)
+{
+    const int size = 120, drones = 6;
+    GridMap map(size, size);
+    map.setSeed(seed);
+    map.populateRandomFires(10);
+    ThreadPool pool(threads);
+    FleetConfig config;
+    Fleet fleet(map, config, pool);
+    FleetTrace trace;
+    fleet.onFiresSeen = [&](const std::vector<std::pair<int,int>>& fires) {
+        trace.fires.insert(trace.fires.end(), fires.begin(), fires.end());
+    };
+    std::vector<std::pair<int,int>> starts;
+    for (int i = 0; i < drones; i++) {
+        int col = i * size / drones;
+        while (col < size - 1 && map.isFire(0, col)) col++;
+        starts.push_back({0, col});
+    }
+    fleet.run(starts);
+    for (const Fleet::Drone& drone : fleet.getDrones()) {
+        trace.moves.push_back(drone.moves);
+        trace.found.push_back(drone.found);
+    }
+    trace.ticks = fleet.getStats().ticks;
+    return trace;
+}
+
+void checkFleet(Check& check, uint64_t seed)
+{
+    FleetTrace serial = flyFleet(seed, 1);
+    FleetTrace parallel = flyFleet(seed, 3);
+    check.expect(serial.ticks == parallel.ticks && serial.moves == parallel.moves,
+                 seed, "the flight differs between 1 and 3 threads");
+    check.expect(serial.found == parallel.found && serial.fires == parallel.fires,
+                 seed, "who saw a cell first differs between 1 and 3 threads");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 20;
+    uint64_t first = 1;
+    double hpaBound = 1.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) first = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--hpa-bound" && i + 1 < argc) hpaBound = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--seeds N] [--seed S] [--hpa-bound B]\n";
+            return 1;
+        }
+    }
+
+    ThreadPool pool(4);
+    Check spread("spread modes"), dstar("d* lite"), connectivity("connectivity"), hpa("hpa*"), batch("batch"), fleet("fleet");
+    double hpaWorst = 1.0;
+    for (uint64_t seed = first; seed < first + (uint64_t)seeds; seed++) {
+        checkSpread(spread, seed, pool);
+        checkDStar(dstar, seed);
+        checkConnectivity(connectivity, seed);
+        hpaWorst = std::max(hpaWorst, checkHpa(hpa, seed, hpaBound));
+        checkBatch(batch, seed);
+        checkFleet(fleet, seed);
+    }
+
+    std::cout << seeds << " seeds from " << first << "\n";
+    bool ok = spread.report();
+    ok &= dstar.report();
+    ok &= connectivity.report();
+    std::ostringstream worst;
+    worst << std::fixed << std::setprecision(3) << ", worst cost " << hpaWorst << "x A*";
+    ok &= hpa.report(worst.str());
+    ok &= batch.report();
+    ok &= fleet.report();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// Load test for the base station: N simulated drones fly the same seeded
+// map from different starts on threads of their own, then stream their
+// binary telemetry to a running station over loopback all at once. The
+// flying happens before the clock starts, so the rates are the station's.
+//
+//   BaseStationServer --quiet --drones 64 &
+//   StationLoad [--drones N] [--port P] [--report-every N] [size]
+//
+// Defaults: 64 drones, port 12345, a window every 16 moves, 256x256 map
+// (10% random fires, seed 1, no spread). Each drone explores the whole map
+// in frontier mode, so the station gets N overlapping coverage streams;
+// compare its fire and seen counts with the totals printed here.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include "GridMap.h"
+#include "Mission.h"
+#include "Net.h"
+#include "Telemetry.h"
+
+namespace {
+
+struct DroneResult {
+    bool connected = false;
+    bool binary = false;
+    uint64_t moves = 0;
+    uint64_t sends = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// One drone: flies its mission offline, keeping the window frames it would
+// send every 'every' moves, then connects and, once every drone is ready,
+// streams them to the station as fast as the socket takes them
+void fly(const GridMap& base, int id, int startRow, int startCol, int port, int every,
+         int drones, std::atomic<int>& flown, std::atomic<int>& ready, DroneResult& result)
+{
+    GridMap map = base;
+    int rows = map.getRows(), cols = map.getCols();
+
+    MissionConfig config;
+    config.spreadEvery = 0;
+    Mission mission(map, config);
+    TelemetryTracker tracker(rows, cols);
+    std::vector<std::string> sends(1);
+    mission.onScan = [&](int top, int left, int bottom, int right) {
+        tracker.scan(map, mission.getDiscovered(), top, left, bottom, right,
+                     mission.getStats().steps, sends.back());
+    };
+    mission.onMove = [&]() {
+        if (mission.getStats().steps % every != 0) return;
+        tracker.flush(sends.back());
+        if (!sends.back().empty()) sends.emplace_back();
+    };
+    mission.run(startRow, startCol);
+    tracker.end(sends.back());
+    result.moves = mission.getStats().steps;
+
+    // Connect only once every drone has flown, so the station's clock (from
+    // its first accept) does not include anyone's flight
+    flown.fetch_add(1);
+    while (flown.load() < drones) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    NetSocket sock = netConnect("127.0.0.1", port);
+    if (sock != NET_INVALID) {
+        std::string hello = "HELLO " + std::to_string(TELEMETRY_VERSION) + " " + std::to_string(id) + " " +
+                            std::to_string(rows) + " " + std::to_string(cols) + "\n";
+        RecvBuffer reply;
+        std::string_view line;
+        result.connected = netSendAll(sock, hello.data(), hello.size());
+        while (result.connected && !reply.nextLine(line)) {
+            result.connected = reply.fill(sock) > 0;
+        }
+        result.binary = result.connected && line == "HELLO 1";
+        std::string confirm = "BINARY 1\n";
+        if (result.binary) result.connected = netSendAll(sock, confirm.data(), confirm.size());
+    }
+    ready.fetch_add(1);
+    if (!result.connected) {
+        if (sock != NET_INVALID) netClose(sock);
+        return;
+    }
+    if (!result.binary) {
+        sends.assign(1, "END\n");     // the station declined binary; just sign off
+    }
+
+    // Wait for the others so the station sees all of them at once
+    while (ready.load() >= 0) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& chunk : sends) {
+        if (!netSendAll(sock, chunk.data(), chunk.size())) break;
+        result.sends++;
+        result.bytes += chunk.size();
+    }
+    netClose(sock);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int drones = 64;
+    int port = 12345;
+    int every = 16;
+    int size = 256;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--drones" && i + 1 < argc) {
+            drones = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--report-every" && i + 1 < argc) {
+            every = std::max(1, std::atoi(argv[++i]));
+        } else {
+            size = std::max(8, std::atoi(arg.c_str()));
+        }
+    }
+    if (!netInit()) {
+        std::cerr << "Socket startup failed.\n";
+        return 1;
+    }
+
+    GridMap map(size, size);
+    map.setSeed(1);
+    map.populateRandomFires(10);
+    uint64_t fires = 0;
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) fires += map.isFire(r, c);
+    }
+
+    // Starts on an even lattice over the map, nudged off fire cells
+    int across = 1;
+    while (across * across < drones) across++;
+    std::vector<DroneResult> results(drones);
+    std::vector<std::thread> threads;
+    std::atomic<int> flown{0}, ready{0};
+    for (int i = 0; i < drones; i++) {
+        int r = (2 * (i / across) + 1) * size / (2 * across);
+        int c = (2 * (i % across) + 1) * size / (2 * across);
+        while (map.isFire(r, c)) c = (c + 1) % size;
+        threads.emplace_back(fly, std::cref(map), i + 1, r, c, port, every, drones,
+                             std::ref(flown), std::ref(ready), std::ref(results[i]));
+    }
+    while (ready.load() < drones) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto start = std::chrono::steady_clock::now();
+    ready.store(-1);
+    for (std::thread& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    DroneResult total;
+    int connected = 0, binary = 0;
+    double slowest = 0;
+    for (const DroneResult& d : results) {
+        connected += d.connected;
+        binary += d.binary;
+        total.moves += d.moves;
+        total.sends += d.sends;
+        total.bytes += d.bytes;
+        slowest = std::max(slowest, d.seconds);
+    }
+    netCleanup();
+
+    std::cout << size << "x" << size << " map, " << fires << " fires; " << drones << " drones, "
+              << connected << " connected, " << binary << " on binary telemetry\n"
+              << total.moves << " moves, " << total.sends << " sends, " << total.bytes << " bytes in "
+              << std::fixed << std::setprecision(2) << seconds << " s (slowest drone "
+              << slowest << " s)\n"
+              << std::setprecision(0) << total.sends / seconds << " sends/s, "
+              << total.bytes / seconds / 1e6 * 8 << " Mbit/s\n";
+    return connected == drones ? 0 : 1;
+}
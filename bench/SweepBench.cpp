@@ -0,0 +1,88 @@
+// Flies complete missions offline and reports planning time and moves for
+// each exploration mode.
+//
+//   SweepBench [--spread p] [--modes sweep,frontier,infogain] [size ...]
+//
+// Sizes default to 500 and 2000 (square maps, 10% random fires, seeded so
+// every mode sees the same map). Fire spread is off by default so every run
+// is a complete sweep; --spread turns it on (every 5 moves).
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "GridMap.h"
+#include "Mission.h"
+
+namespace {
+
+struct ModeName {
+    const char* name;
+    ExploreMode mode;
+};
+
+const ModeName MODES[] = {
+    {"sweep", ExploreMode::Sweep},
+    {"frontier", ExploreMode::Frontier},
+    {"infogain", ExploreMode::InfoGain},
+};
+
+void runOne(int size, const ModeName& mode, double spread)
+{
+    GridMap map(size, size);
+    map.setSeed(1);
+    map.populateRandomFires(10);
+    int startCol = 0;
+    while (startCol < size && map.isFire(0, startCol)) startCol++;
+
+    MissionConfig config;
+    config.mode = mode.mode;
+    config.spreadChance = spread;
+    config.spreadEvery = spread > 0 ? 5 : 0;
+    Mission mission(map, config);
+
+    auto begin = std::chrono::steady_clock::now();
+    bool complete = mission.run(0, startCol);
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    const Mission::Stats& s = mission.getStats();
+    std::cout << std::setw(5) << size << "x" << std::left << std::setw(6) << size
+              << std::setw(10) << mode.name << std::right
+              << std::setw(10) << s.steps
+              << std::setw(10) << s.decisions
+              << std::setw(12) << std::fixed << std::setprecision(1) << s.planNanos / 1e6
+              << std::setw(12) << totalMs
+              << std::setw(11) << mission.getUndiscovered()
+              << "  " << (complete ? "done" : "signal lost") << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    std::string modes = "sweep,frontier,infogain";
+    double spread = 0.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--spread" && i + 1 < argc) {
+            spread = std::atof(argv[++i]);
+        } else if (arg == "--modes" && i + 1 < argc) {
+            modes = argv[++i];
+        } else {
+            sizes.push_back(std::atoi(arg.c_str()));
+        }
+    }
+    if (sizes.empty()) sizes = {500, 2000};
+
+    std::cout << "map         mode           moves  planning   plan (ms)  total (ms)  unseen\n";
+    for (int size : sizes) {
+        for (const ModeName& mode : MODES) {
+            if (("," + modes + ",").find("," + std::string(mode.name) + ",") == std::string::npos) continue;
+            runOne(size, mode, spread);
+        }
+    }
+    return 0;
+}
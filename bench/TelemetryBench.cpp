@@ -0,0 +1,182 @@
+// Flies a complete sweep offline and compares what each wire format would
+// send to the base station, then times the binary decoder on the result.
+//
+//   TelemetryBench [--mode sweep|frontier] [--report-every N] [size]
+//
+// The map is square (default 2000), 10% random fires, seeded, no spread.
+//   text:      one "FIRE r c" line per fire (the original protocol)
+//   batch:     one "FIRE r c" / "FIREBATCH n ..." line per perception update
+//   binary/1:  window frames of changed cells, flushed after every move
+//   binary/N:  the same, flushed every N moves (default 64)
+// The binary formats also tell the station about every clear cell.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "GridMap.h"
+#include "Mission.h"
+#include "Telemetry.h"
+
+namespace {
+
+struct Traffic {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+};
+
+void printTraffic(const std::string& name, const Traffic& t, uint64_t fires)
+{
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(12) << t.messages
+              << std::setw(14) << t.bytes
+              << std::setw(14) << std::fixed << std::setprecision(2) << (double)t.bytes / fires << "\n";
+}
+
+// Binary stream of one flush interval, with the time spent producing it
+struct BinaryStream {
+    BinaryStream(int size, int every) : tracker(size, size), every(every) {}
+    TelemetryTracker tracker;
+    int every;
+    std::string wire;
+    size_t flushedAt = 0;
+    Traffic traffic;
+    double encodeNs = 0;
+
+    void flush() {
+        tracker.flush(wire);
+        if (wire.size() > flushedAt) {
+            traffic.messages++;
+            flushedAt = wire.size();
+        }
+    }
+};
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int size = 2000;
+    int every = 64;
+    ExploreMode mode = ExploreMode::Sweep;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mode" && i + 1 < argc) {
+            mode = std::string(argv[++i]) == "frontier" ? ExploreMode::Frontier : ExploreMode::Sweep;
+        } else if (arg == "--report-every" && i + 1 < argc) {
+            every = std::max(1, std::atoi(argv[++i]));
+        } else {
+            size = std::atoi(arg.c_str());
+        }
+    }
+
+    GridMap map(size, size);
+    map.setSeed(1);
+    map.populateRandomFires(10);
+    int startCol = 0;
+    while (startCol < size && map.isFire(0, startCol)) startCol++;
+
+    MissionConfig config;
+    config.mode = mode;
+    config.spreadEvery = 0;
+    Mission mission(map, config);
+
+    // What the text protocols would send
+    uint64_t fires = 0;
+    Traffic text, batch;
+    mission.onFiresSeen = [&](const std::vector<std::pair<int,int>>& seen) {
+        fires += seen.size();
+        std::string line;
+        for (auto [r, c] : seen) {
+            line = "FIRE " + std::to_string(r) + " " + std::to_string(c) + "\n";
+            text.messages++;
+            text.bytes += line.size();
+        }
+        line = seen.size() == 1 ? "FIRE" : "FIREBATCH " + std::to_string(seen.size());
+        for (auto [r, c] : seen) line += " " + std::to_string(r) + " " + std::to_string(c);
+        batch.messages++;
+        batch.bytes += line.size() + 1;
+    };
+
+    // The binary streams; the move count stands in for the clock
+    BinaryStream streams[2] = {BinaryStream(size, 1), BinaryStream(size, every)};
+    mission.onScan = [&](int top, int left, int bottom, int right) {
+        for (BinaryStream& stream : streams) {
+            auto start = std::chrono::steady_clock::now();
+            stream.tracker.scan(map, mission.getDiscovered(), top, left, bottom, right,
+                                mission.getStats().steps, stream.wire);
+            stream.encodeNs += since(start);
+        }
+    };
+    mission.onMove = [&]() {
+        for (BinaryStream& stream : streams) {
+            if (mission.getStats().steps % stream.every != 0) continue;
+            auto start = std::chrono::steady_clock::now();
+            stream.flush();
+            stream.encodeNs += since(start);
+        }
+    };
+    bool complete = mission.run(0, startCol);
+
+    // Decode the every-move stream onto a station map and check it matches
+    // what the drone knows
+    std::vector<uint8_t> station((size_t)size * size, 0);
+    size_t frames = 0;
+    for (BinaryStream& stream : streams) {
+        stream.tracker.end(stream.wire);
+        stream.traffic.messages++;
+        stream.traffic.bytes = stream.wire.size();
+    }
+    const std::string& wire = streams[0].wire;
+    TelemetryDecoder decoder;
+    TelemetryFrame frame;
+    size_t pos = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (pos < wire.size()) {
+        long used = decoder.decode(wire.data() + pos, wire.size() - pos, frame);
+        if (used <= 0) break;
+        pos += (size_t)used;
+        frames++;
+        if (frame.type != FrameType::Window) continue;
+        const uint8_t* state = frame.cells.data();
+        for (int r = frame.top; r < frame.top + frame.rows; r++) {
+            for (int c = frame.left; c < frame.left + frame.cols; c++, state++) {
+                if (*state & CELL_DISCOVERED) station[(size_t)r * size + c] = *state;
+            }
+        }
+    }
+    double decodeNs = since(start);
+
+    bool same = pos == wire.size();
+    const auto& discovered = mission.getDiscovered();
+    for (int r = 0; r < size && same; r++) {
+        for (int c = 0; c < size; c++) {
+            uint8_t expected = discovered.isDiscovered(r, c) ? CELL_DISCOVERED | (map.isFire(r, c) ? CELL_FIRE : 0) : 0;
+            if (station[(size_t)r * size + c] != expected) same = false;
+        }
+    }
+
+    std::cout << size << "x" << size << (mode == ExploreMode::Sweep ? " sweep" : " frontier")
+              << ", " << mission.getStats().steps << " moves, " << fires << " fires"
+              << (complete ? "" : " (signal lost)") << "\n\n";
+    std::cout << "format       messages         bytes    bytes/fire\n";
+    printTraffic("text", text, fires);
+    printTraffic("batch", batch, fires);
+    printTraffic("binary/1", streams[0].traffic, fires);
+    printTraffic("binary/" + std::to_string(every), streams[1].traffic, fires);
+
+    std::cout << "\nbinary/1: " << frames << " frames, " << std::setprecision(1)
+              << (double)wire.size() / frames << " bytes/frame\n"
+              << "  encode " << streams[0].encodeNs / frames << " ns/frame (scans and flushes)\n"
+              << "  decode " << decodeNs / frames << " ns/frame, "
+              << wire.size() / (decodeNs / 1e3) << " MB/s, applied to the station map"
+              << (same ? "" : "  STATION MAP MISMATCH") << "\n";
+    return 0;
+}
@@ -1,168 +1,577 @@
 #include <iostream>
+#include <iomanip>
 #include <vector>
 #include <string>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Net.h"
+#include "StationMap.h"
+#include "Telemetry.h"
+#include "MapRenderer.h"
+#include "MissionLog.h"
+#include "Probe.h"
 
 static const int PORT = 12345;
 
-// Clears the console
-void clearScreen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    system("clear");
-#endif
-}
+// Grid used when a drone reports without telling us its size
+static const int DEFAULT_ROWS = 15, DEFAULT_COLS = 15;
 
-// Print a row separator for a grid
-void printRowSeparator(int cols) {
-    std::cout << "+";
-    for (int j = 0; j < cols; j++) {
-        std::cout << "---+";
+// Command-line options
+struct Options {
+    int port = PORT;
+    int drones = 1;         // exit after this many drones finished, 0 = never
+    bool quiet = false;     // no live redraw (load tests)
+    int rows = 0, cols = 0; // 0 = take the grid from the first drone's HELLO
+    int threads = 0;        // ingest threads, 0 = one per core
+    double fps = 10;        // map redraws per second at most
+    std::string logFile;    // mission log, empty = none
+};
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            opt.port = std::atoi(argv[++i]);
+        } else if (arg == "--drones" && i + 1 < argc) {
+            opt.drones = std::atoi(argv[++i]);
+        } else if (arg == "--quiet") {
+            opt.quiet = true;
+        } else if (arg == "--grid" && i + 2 < argc) {
+            opt.rows = std::atoi(argv[++i]);
+            opt.cols = std::atoi(argv[++i]);
+            if (opt.rows <= 0 || opt.cols <= 0) return false;
+        } else if (arg == "--fps" && i + 1 < argc) {
+            opt.fps = std::atof(argv[++i]);
+            if (opt.fps <= 0) return false;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            opt.threads = std::atoi(argv[++i]);
+            if (opt.threads < 0) return false;
+        } else if (arg == "--log" && i + 1 < argc) {
+            opt.logFile = argv[++i];
+        } else {
+            return false;
+        }
     }
-    std::cout << "\n";
+    return true;
+}
+
+// Reads "<spaces>number" at 'p'; advances 'p' past it
+bool parseInt(const char*& p, const char* end, int& value) {
+    while (p < end && *p == ' ') p++;
+    auto res = std::from_chars(p, end, value);
+    if (res.ec != std::errc()) return false;
+    p = res.ptr;
+    return true;
+}
+
+// Parses the coordinates of "FIRE r c" straight from the receive buffer
+bool parseFire(std::string_view line, int& r, int& c) {
+    const char* p = line.data() + 4;
+    const char* end = line.data() + line.size();
+    return parseInt(p, end, r) && parseInt(p, end, c);
 }
 
-// Display the server’s blank grid with discovered fires
-void displayServerMap(const std::vector<std::vector<char>>& serverMap) {
-    int rows = (int)serverMap.size();
-    if (rows == 0) return;
-    int cols = (int)serverMap[0].size();
-
-    for (int r = 0; r < rows; r++) {
-        printRowSeparator(cols);
-        for (int c = 0; c < cols; c++) {
-            std::cout << "| ";
-            if (serverMap[r][c] == 'X') {
-                std::cout << "X ";
-            } else {
-                std::cout << "  ";
+// What one drone reported over its connection
+struct DroneRecord {
+    int id = 0;                 // connection number
+    int droneId = 0;            // the id it gave in HELLO, 0 if none
+    uint64_t messages = 0;
+    DroneCoverage coverage;
+};
+
+// One drone connection and what it has sent so far
+struct Connection {
+    NetSocket sock = NET_INVALID;
+    // Room for a few of the largest frames; a drone that sends more without
+    // finishing a line or frame is dropped
+    RecvBuffer reader{4096, 4 * TELEMETRY_MAX_FRAME};
+    int offered = 0;            // telemetry version answered to HELLO
+    int version = 0;            // version in use once the drone confirms it, 0 = text
+    TelemetryDecoder decoder;
+    TelemetryFrame frame;
+    StationMap* map = nullptr;  // set by HELLO or the first report
+    DroneRecord record;
+    std::vector<uint64_t> logCells; // reported by the message being handled, for the log
+};
+
+// State shared by the accept loop and the ingest threads
+struct Station {
+    Options opt;
+    std::atomic<StationMap*> map{nullptr};
+    std::atomic<int> finished{0};
+    std::atomic<int64_t> lastFinish{0};     // steady clock ticks of the latest disconnect
+    std::atomic<bool> dirty{false};     // the map changed since the last redraw
+    std::atomic<bool> scrolled{false};  // a log line moved the map on screen
+    std::atomic<bool> stopping{false};
+
+    std::mutex mapLock;
+    std::unique_ptr<StationMap> mapOwner;
+
+    // Opened along with the map, before it is published: a connection that
+    // has the map can log
+    MissionLog missionLog;
+
+    std::mutex printLock;
+
+    std::mutex doneLock;
+    std::vector<DroneRecord> done;      // drones that disconnected
+
+    // The shared map, created at the first drone's grid size if --grid did
+    // not fix it; later drones join it whatever size they asked for
+    StationMap* mapFor(int rows, int cols) {
+        StationMap* current = map.load(std::memory_order_acquire);
+        if (current) return current;
+        std::lock_guard<std::mutex> guard(mapLock);
+        if (!mapOwner) {
+            mapOwner = std::make_unique<StationMap>(rows, cols);
+            std::string error;
+            if (!opt.logFile.empty() && !missionLog.open(opt.logFile, rows, cols, 0, error)) {
+                std::cerr << "[Server] " << error << "; not logging\n";
+            }
+            map.store(mapOwner.get(), std::memory_order_release);
+        }
+        return mapOwner.get();
+    }
+
+    void log(const std::string& message) {
+        if (opt.quiet) return;
+        std::lock_guard<std::mutex> guard(printLock);
+        std::cout << message;
+        scrolled.store(true, std::memory_order_relaxed);
+    }
+};
+
+// Reads a share of the drone connections on its own thread. The accept loop
+// hands it sockets through an inbox; everything else it touches is its own,
+// apart from the shared map, which takes concurrent writes.
+class IngestWorker {
+public:
+    explicit IngestWorker(Station& station) : station(station) {}
+
+    void start() { thread = std::thread(&IngestWorker::run, this); }
+    void join() { if (thread.joinable()) thread.join(); }
+
+    // Called by the accept loop
+    void hand(NetSocket s, int id) {
+        std::lock_guard<std::mutex> guard(inboxLock);
+        inbox.push_back({s, id});
+    }
+
+    uint64_t getMessages() const { return messages; }
+
+    // Open connections; valid after join()
+    std::vector<DroneRecord> takeOpen() {
+        std::vector<DroneRecord> records;
+        for (auto& entry : drones) {
+            netClose(entry.first);
+            records.push_back(std::move(entry.second.record));
+        }
+        drones.clear();
+        return records;
+    }
+
+private:
+    void run();
+    void adopt();
+    bool drain(Connection& drone);
+    bool handleLine(Connection& drone, std::string_view line);
+    bool handleFrame(Connection& drone, const TelemetryFrame& frame);
+    void report(Connection& drone, int r, int c, bool onFire);
+    void logCells(Connection& drone);
+    void disconnect(NetSocket s);
+
+    Station& station;
+    std::thread thread;
+    Poller poller;
+    std::unordered_map<NetSocket, Connection> drones;
+    std::vector<NetSocket> ready;
+    uint64_t messages = 0;
+
+    std::mutex inboxLock;
+    std::vector<std::pair<NetSocket, int>> inbox;
+    std::vector<std::pair<NetSocket, int>> adopted;
+};
+
+void IngestWorker::run() {
+    while (!station.stopping.load(std::memory_order_relaxed)) {
+        adopt();
+        // Short timeout so new sockets in the inbox are picked up promptly
+        if (!poller.wait(ready, 10)) {
+            std::cerr << "[Server] poll failed.\n";
+            break;
+        }
+        for (NetSocket s : ready) {
+            auto it = drones.find(s);
+            if (it == drones.end()) continue;
+            if (!drain(it->second)) {
+                disconnect(s);
             }
         }
-        std::cout << "|\n";
     }
-    printRowSeparator(cols);
 }
 
-// Receive a single line
-bool recvLine(SOCKET s, std::string& out) {
-    out.clear();
-    char c;
+void IngestWorker::adopt() {
+    {
+        std::lock_guard<std::mutex> guard(inboxLock);
+        adopted.swap(inbox);
+    }
+    for (auto [s, id] : adopted) {
+        Connection& drone = drones[s];
+        drone.sock = s;
+        drone.record.id = id;
+        poller.add(s);
+    }
+    adopted.clear();
+}
+
+void IngestWorker::disconnect(NetSocket s) {
+    poller.remove(s);
+    netClose(s);
+    auto it = drones.find(s);
+    {
+        std::lock_guard<std::mutex> guard(station.doneLock);
+        station.done.push_back(std::move(it->second.record));
+    }
+    drones.erase(it);
+    station.lastFinish.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    station.finished.fetch_add(1);
+}
+
+// Reads what the socket has; returns false once the drone is gone or done
+bool IngestWorker::drain(Connection& drone) {
+    PROBE_SCOPE("station.drain");
     while (true) {
-        int ret = recv(s, &c, 1, 0);
-        if (ret <= 0) {
-            // Error or disconnected
+        int n = drone.reader.fill(drone.sock);
+        if (n == NET_WOULD_BLOCK) return true;
+        if (n == NET_TOO_LONG) {
+            station.log("[Server] Drone " + std::to_string(drone.record.id) +
+                        " sent too much without ending a message.\n");
             return false;
         }
-        if (c == '\n') {
-            break;
+        if (n <= 0) {
+            station.log("[Server] Drone " + std::to_string(drone.record.id) + " disconnected or error.\n");
+            return false;
+        }
+        // Hand over every complete line or frame; the buffer keeps the tail
+        while (true) {
+            if (drone.version == 0) {
+                std::string_view line;
+                if (!drone.reader.nextLine(line)) break;
+                if (!handleLine(drone, line)) return false;
+                continue;
+            }
+            long used = drone.decoder.decode(drone.reader.data(), drone.reader.size(), drone.frame);
+            if (used == 0) break;
+            if (used < 0) {
+                std::cerr << "[Server] Drone " << drone.record.id << " sent a malformed frame.\n";
+                return false;
+            }
+            if (drone.map) station.missionLog.message(drone.record.id, drone.reader.data(), (size_t)used);
+            drone.reader.consume((size_t)used);
+            if (!handleFrame(drone, drone.frame)) return false;
         }
-        out.push_back(c);
+    }
+}
+
+void IngestWorker::report(Connection& drone, int r, int c, bool onFire) {
+    if (!drone.map) drone.map = station.mapFor(DEFAULT_ROWS, DEFAULT_COLS);
+    drone.record.coverage.report(*drone.map, r, c, onFire);
+    if (station.missionLog.isOpen() && r >= 0 && r < drone.map->getRows() && c >= 0 && c < drone.map->getCols()) {
+        drone.logCells.push_back(((uint64_t)r * drone.map->getCols() + c) * 2 + (onFire ? 1 : 0));
+    }
+}
+
+// One Cells record for what the message just handled reported
+void IngestWorker::logCells(Connection& drone) {
+    if (drone.logCells.empty()) return;
+    station.missionLog.cells(drone.record.id, drone.logCells);
+    drone.logCells.clear();
+}
+
+// We expect lines like: "FIRE r c", "FIREBATCH n r1 c1 ... rn cn",
+// "HELLO version droneId rows cols", "BINARY version" or "END". Returns
+// false once the drone is done.
+bool IngestWorker::handleLine(Connection& drone, std::string_view line) {
+    PROBE_SCOPE("station.line");
+    messages++;
+    drone.record.messages++;
+    uint64_t firesBefore = drone.record.coverage.firstFires;
+    if (line.substr(0, 5) == "HELLO") {
+        // Answer with the telemetry version we both speak; binary frames
+        // follow the drone's "BINARY" confirmation. Older drones leave out
+        // the grid size.
+        const char* p = line.data() + 5;
+        const char* end = line.data() + line.size();
+        int version, droneId, rows, cols;
+        if (parseInt(p, end, version) && parseInt(p, end, droneId)) {
+            drone.offered = std::max(0, std::min(version, TELEMETRY_VERSION));
+            drone.record.droneId = droneId;
+            std::string reply = "HELLO " + std::to_string(drone.offered) + "\n";
+            netSendAll(drone.sock, reply.data(), reply.size());
+
+            if (parseInt(p, end, rows) && parseInt(p, end, cols) && rows > 0 && cols > 0) {
+                // Frames must stay on the grid the drone flies; what lies
+                // off the station's map is dropped cell by cell
+                drone.decoder.setBounds(rows, cols);
+                drone.map = station.mapFor(rows, cols);
+                if (rows != drone.map->getRows() || cols != drone.map->getCols()) {
+                    station.log("[Server] Drone " + std::to_string(drone.record.id) + " flies a " +
+                                std::to_string(rows) + "x" + std::to_string(cols) + " grid; the map is " +
+                                std::to_string(drone.map->getRows()) + "x" +
+                                std::to_string(drone.map->getCols()) + "\n");
+                }
+            }
+            station.log("[Server] Drone " + std::to_string(drone.record.id) + " is drone #" +
+                        std::to_string(droneId) + (drone.offered ? ", offered binary telemetry\n" : ", text\n"));
+        }
+    }
+    else if (line.substr(0, 6) == "BINARY") {
+        // The drone got our answer in time: frames from the next byte on
+        const char* p = line.data() + 6;
+        int version;
+        if (parseInt(p, line.data() + line.size(), version) && version > 0 && version == drone.offered) {
+            drone.version = version;
+            if (!drone.map) {
+                drone.map = station.mapFor(DEFAULT_ROWS, DEFAULT_COLS);
+                drone.decoder.setBounds(drone.map->getRows(), drone.map->getCols());
+            }
+        }
+    }
+    else if (line.substr(0, 9) == "FIREBATCH") {
+        // line example: "FIREBATCH 2 3 5 3 6"
+        const char* p = line.data() + 9;
+        const char* end = line.data() + line.size();
+        int n, r, c;
+        if (parseInt(p, end, n)) {
+            int marked = 0;
+            while (marked < n && parseInt(p, end, r) && parseInt(p, end, c)) {
+                report(drone, r, c, true);
+                marked++;
+            }
+        }
+    }
+    else if (line.substr(0, 4) == "FIRE") {
+        // line example: "FIRE 3 5"
+        int r, c;
+        if (parseFire(line, r, c)) {
+            report(drone, r, c, true);
+        }
+    }
+    else if (line == "END") {
+        station.log("[Server] Drone " + std::to_string(drone.record.id) + " ended scanning.\n");
+        if (drone.map) station.missionLog.message(drone.record.id, line.data(), line.size());
+        return false;
+    }
+    else {
+        station.log("[Server] Unknown command: " + std::string(line) + "\n");
+    }
+    if (drone.map) {
+        station.missionLog.message(drone.record.id, line.data(), line.size());
+        logCells(drone);
+    }
+    if (drone.record.coverage.firstFires != firesBefore) {
+        station.dirty.store(true, std::memory_order_relaxed);
     }
     return true;
 }
 
-int main() {
-    // init winsock
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
-        std::cerr << "WSAStartup failed.\n";
-        return 1;
+// Binary telemetry. Returns false once the drone is done.
+bool IngestWorker::handleFrame(Connection& drone, const TelemetryFrame& frame) {
+    PROBE_SCOPE("station.frame");
+    messages++;
+    drone.record.messages++;
+    if (frame.type == FrameType::End) {
+        station.log("[Server] Drone " + std::to_string(drone.record.id) + " ended scanning.\n");
+        return false;
     }
+    if (frame.type != FrameType::Window) return true;
 
-    //Create a TCP socket
-    SOCKET serverSock = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverSock == INVALID_SOCKET) {
-        std::cerr << "socket() failed.\n";
-        WSACleanup();
-        return 1;
+    // Cells the drone saw: fires and clear cells both go on the map
+    uint64_t firesBefore = drone.record.coverage.firstFires;
+    const uint8_t* state = frame.cells.data();
+    for (int r = frame.top; r < frame.top + frame.rows; r++) {
+        for (int c = frame.left; c < frame.left + frame.cols; c++, state++) {
+            if (*state & CELL_DISCOVERED) {
+                report(drone, r, c, (*state & CELL_FIRE) != 0);
+            }
+        }
+    }
+    logCells(drone);
+    if (drone.record.coverage.firstFires != firesBefore) {
+        station.dirty.store(true, std::memory_order_relaxed);
     }
+    return true;
+}
 
-    // bind to port 12345
-    sockaddr_in serverAddr;
-    memset(&serverAddr, 0, sizeof(serverAddr));
-    serverAddr.sin_family      = AF_INET;
-    serverAddr.sin_port        = htons(PORT);
-    serverAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+// Per-drone coverage: what each drone reported and how much of it was news
+void printCoverage(std::vector<DroneRecord>& records, const StationMap* map) {
+    std::sort(records.begin(), records.end(),
+              [](const DroneRecord& a, const DroneRecord& b) { return a.id < b.id; });
+    double cells = map ? (double)map->getRows() * map->getCols() : 0;
+    auto precision = std::cout.precision();
+    std::cout << "[Server] Coverage by drone:\n"
+              << "  conn  drone  messages     seen  % map    fires  first seen  first fires\n";
+    for (const DroneRecord& d : records) {
+        std::cout << std::setw(6) << d.id << std::setw(7) << d.droneId
+                  << std::setw(10) << d.messages
+                  << std::setw(9) << d.coverage.cells
+                  << std::setw(7) << std::fixed << std::setprecision(1)
+                  << (cells > 0 ? 100.0 * d.coverage.cells / cells : 0.0)
+                  << std::setw(9) << d.coverage.fires
+                  << std::setw(12) << d.coverage.firstCells
+                  << std::setw(13) << d.coverage.firstFires << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout.precision(precision);
+}
 
-    if (bind(serverSock, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        std::cerr << "bind() failed.\n";
-        closesocket(serverSock);
-        WSACleanup();
+int main(int argc, char** argv) {
+    Station station;
+    Options& opt = station.opt;
+    if (!parseOptions(argc, argv, opt)) {
+        std::cerr << "Usage: " << argv[0] << " [--port N] [--drones N] [--quiet] [--grid ROWS COLS] [--threads N] [--fps N] [--log FILE]\n"
+                  << "  --drones N   exit once N drones have finished (default 1, 0 = run forever)\n"
+                  << "  --quiet      don't redraw the map or log drones (load tests)\n"
+                  << "  --grid R C   fix the map size (default: the first drone's grid)\n"
+                  << "  --threads N  ingest threads (default: one per core)\n"
+                  << "  --fps N      redraw the map at most N times a second (default 10)\n"
+                  << "  --log FILE   record every message and reported cell (see LogReplay)\n";
         return 1;
     }
+    if (opt.rows > 0) {
+        station.mapFor(opt.rows, opt.cols);
+    }
 
-    // Listen
-    if (listen(serverSock, 1) == SOCKET_ERROR) {
-        std::cerr << "listen() failed.\n";
-        closesocket(serverSock);
-        WSACleanup();
+    // init sockets
+    if (!netInit()) {
+        std::cerr << "Socket startup failed.\n";
         return 1;
     }
 
-    std::cout << "[Server] Listening on port " << PORT << "...\n";
-
-    //Accept the drone’s connection
-    sockaddr_in clientAddr;
-    int clientSize = sizeof(clientAddr);
-    SOCKET clientSock = accept(serverSock, (sockaddr*)&clientAddr, &clientSize);
-    if (clientSock == INVALID_SOCKET) {
-        std::cerr << "accept() failed.\n";
-        closesocket(serverSock);
-        WSACleanup();
+    // Listen on the port; every drone gets its own connection
+    NetSocket listener = netListen(opt.port, SOMAXCONN);
+    if (listener == NET_INVALID) {
+        std::cerr << "Could not listen on port " << opt.port << ".\n";
+        netCleanup();
         return 1;
     }
+    std::cout << "[Server] Listening on port " << opt.port << "...\n";
 
-    std::cout << "[Server] Drone connected!\n";
+    // Connections are dealt round-robin to the ingest threads
+    int threads = opt.threads > 0 ? opt.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<IngestWorker>> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::make_unique<IngestWorker>(station));
+        workers.back()->start();
+    }
+
+    Poller poller;
+    poller.add(listener);
+    std::vector<NetSocket> ready;
+    int nextId = 1;
+    uint64_t accepted = 0;
+    // Rates are measured from the first connection, not from startup
+    auto start = std::chrono::steady_clock::now();
 
-    // We create a blank 15x15 grid on the server
-    int rows = 15;
-    int cols = 15;
-    std::vector<std::vector<char>> serverMap(rows, std::vector<char>(cols, ' '));
+    // Live map, created along with the shared map; only changed cells are
+    // redrawn
+    std::unique_ptr<MapRenderer> renderer;
+    auto fireGlyph = [&](int r, int c) { return station.map.load()->isFire(r, c) ? 'X' : ' '; };
+    auto status = [&](StationMap& map) {
+        return "[Server] " + std::to_string(accepted) + " drones connected, " +
+               std::to_string(station.finished.load()) + " finished, " +
+               std::to_string(map.countSeen()) + " cells seen, " + std::to_string(map.countFire()) + " fires";
+    };
+    int frameMs = std::max(1, (int)(1000 / opt.fps));
 
-    //    We expect lines like: "FIRE r c" or "END"
-    bool running = true;
-    while (running) {
-        std::string line;
-        if (!recvLine(clientSock, line)) {
-            std::cout << "[Server] Drone disconnected or error.\n";
+    // Accept loop; also redraws the map while it changes
+    while (opt.drones == 0 || station.finished.load() < opt.drones) {
+        if (!poller.wait(ready, std::min(250, frameMs))) {
+            std::cerr << "[Server] poll failed.\n";
             break;
         }
-
-        if (line.rfind("FIRE", 0) == 0) {
-            // line example: "FIRE 3 5"
-            int r, c;
-            if (sscanf(line.c_str(), "FIRE %d %d", &r, &c) == 2) {
-                // Mark that cell as discovered fire
-                if (r >= 0 && r < rows && c >= 0 && c < cols) {
-                    serverMap[r][c] = 'X';
-                }
-
-                // Re-display
-                clearScreen();
-                std::cout << "[Server] Fire discovered at (" << r << "," << c << ")\n";
-                displayServerMap(serverMap);
+        if (!ready.empty()) {
+            NetSocket client;
+            while ((client = netAccept(listener)) != NET_INVALID) {
+                if (accepted == 0) start = std::chrono::steady_clock::now();
+                int id = nextId++;
+                workers[accepted % workers.size()]->hand(client, id);
+                accepted++;
+                station.log("[Server] Drone " + std::to_string(id) + " connected!\n");
             }
         }
-        else if (line == "END") {
-            std::cout << "[Server] Drone ended scanning.\n";
-            running = false;
+        StationMap* map = station.map.load(std::memory_order_acquire);
+        if (opt.quiet || !map) continue;
+        if (!renderer) renderer = std::make_unique<MapRenderer>(map->getRows(), map->getCols(), opt.fps, "X");
+        if (!station.dirty.load() && !station.scrolled.load()) continue;
+        std::lock_guard<std::mutex> guard(station.printLock);
+        if (station.scrolled.load()) renderer->invalidate();
+        if (renderer->draw(status(*map), fireGlyph)) {
+            station.dirty = false;
+            station.scrolled = false;
         }
-        else {
-            std::cout << "[Server] Unknown command: " << line << "\n";
+    }
+
+    station.stopping = true;
+    uint64_t messages = 0;
+    for (auto& worker : workers) {
+        worker->join();
+        messages += worker->getMessages();
+    }
+    // Up to the last drone's disconnect; the accept loop notices it late
+    auto end = std::chrono::steady_clock::now();
+    if (station.lastFinish.load() > 0) {
+        end = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(station.lastFinish.load()));
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::vector<DroneRecord> records = std::move(station.done);
+    for (auto& worker : workers) {
+        for (DroneRecord& record : worker->takeOpen()) {
+            records.push_back(std::move(record));
         }
     }
 
     // Final display
-    std::cout << "[Server] Final discovered map:\n";
-    displayServerMap(serverMap);
+    StationMap* map = station.map.load();
+    uint64_t fires = map ? map->countFire() : 0;
+    uint64_t seen = map ? map->countSeen() : 0;
+    if (map) {
+        if (!renderer) renderer = std::make_unique<MapRenderer>(map->getRows(), map->getCols(), opt.fps, "X");
+        if (station.scrolled.load()) renderer->invalidate();
+        renderer->draw("[Server] Final discovered map:", fireGlyph, true);
+    }
+    printCoverage(records, map);
+    std::cout << "[Server] " << accepted << " connections on " << threads << " threads, "
+              << messages << " messages, " << fires << " fire cells, " << seen << " cells seen in "
+              << seconds << " s (" << (seconds > 0 ? accepted / seconds : 0.0) << " connections/s, "
+              << (seconds > 0 ? messages / seconds : 0.0) << " messages/s)\n";
+    if (station.missionLog.isOpen()) {
+        station.missionLog.close();
+        const MissionLog::Stats& ls = station.missionLog.getStats();
+        std::cout << "[Server] Logged " << ls.events << " events (" << ls.bytes << " bytes) to "
+                  << opt.logFile << (ls.failed ? "; writing failed\n" : "\n");
+    }
+    if (PROBES_ENABLED) {
+        std::cout << "[Server] probes: ";
+        probeReportJson(std::cout);
+        std::cout << "\n";
+    }
 
     // Cleanup
-    closesocket(clientSock);
-    closesocket(serverSock);
-    WSACleanup();
+    netClose(listener);
+    netCleanup();
+#ifdef _WIN32
     system("pause");
+#endif
     return 0;
 }
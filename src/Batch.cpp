@@ -0,0 +1,86 @@
+#include "Batch.h"
+#include "GridMap.h"
+#include "Rng.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// What one concurrent mission needs; the mission keeps a reference to the
+// map, so arenas stay where they were made
+struct Arena {
+    GridMap map;
+    Mission mission;
+    uint64_t fires = 0;
+
+    Arena(const BatchConfig& config)
+        : map(config.rows, config.cols), mission(map, config.mission) {
+        mission.onFiresSeen = [this](const std::vector<std::pair<int,int>>& seen) { fires += seen.size(); };
+    }
+};
+
+} // namespace
+
+uint64_t batchSeed(uint64_t seed, int index)
+{
+    return counterHash(seed, (uint64_t)index);
+}
+
+BatchResult runBatch(const BatchConfig& config)
+{
+    BatchResult result;
+    result.missions.resize(std::max(0, config.missions));
+    ThreadPool pool(config.threads);
+    result.threads = pool.size();
+
+    std::mutex arenaLock;
+    std::vector<std::unique_ptr<Arena>> arenas;     // every arena made
+    std::vector<Arena*> idle;
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor((int)result.missions.size(), [&](int i) {
+        Arena* arena;
+        {
+            std::lock_guard<std::mutex> guard(arenaLock);
+            if (idle.empty()) {
+                arenas.push_back(std::make_unique<Arena>(config));
+                idle.push_back(arenas.back().get());
+            }
+            arena = idle.back();
+            idle.pop_back();
+        }
+
+        BatchMission& out = result.missions[i];
+        out.seed = batchSeed(config.seed, i);
+        GridMap& map = arena->map;
+        map.clear();
+        map.setSeed(out.seed);
+        map.populateRandomFires(config.firePercent);
+        int cols = config.cols;
+        int col = config.startCol;
+        for (int tries = 0; tries < cols && map.isFire(config.startRow, col); tries++) col = (col + 1) % cols;
+        out.startRow = config.startRow;
+        out.startCol = col;
+        if (map.isFire(config.startRow, col)) {
+            out.lost = true;
+            out.undiscovered = config.rows * cols;
+        } else {
+            arena->fires = 0;
+            out.lost = !arena->mission.run(config.startRow, col);
+            const Mission::Stats& stats = arena->mission.getStats();
+            out.steps = stats.steps;
+            out.planNanos = stats.planNanos;
+            out.firesFound = arena->fires;
+            out.undiscovered = arena->mission.getUndiscovered();
+        }
+
+        std::lock_guard<std::mutex> guard(arenaLock);
+        idle.push_back(arena);
+    });
+    result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.arenas = (int)arenas.size();
+    return result;
+}
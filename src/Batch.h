@@ -0,0 +1,49 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <vector>
+#include <cstdint>
+
+#include "Mission.h"
+
+// Many independent missions over random fire maps, for statistics: how
+// long coverage takes, how often fire cuts the drone off.
+//  - Mission i flies a map seeded with batchSeed(seed, i), so each mission
+//    can be flown again alone (DroneClient --seed) and the results do not
+//    depend on the number of threads.
+//  - Missions run on a pool, one task each. A task borrows a worker arena
+//    (a map and a mission with its search buffers) and gives it back, so
+//    once every arena has flown a mission the runs allocate nothing.
+struct BatchConfig {
+    int missions = 100;
+    int rows = 100, cols = 100;
+    int startRow = 0, startCol = 0;     // first clear cell from here along the row
+    int firePercent = 10;
+    uint64_t seed = 0;
+    int threads = 0;                    // 0 = one per core
+    MissionConfig mission;
+};
+
+struct BatchMission {
+    uint64_t seed = 0;
+    int startRow = 0, startCol = 0;     // where the drone took off
+    uint64_t steps = 0;         // moves flown
+    uint64_t firesFound = 0;
+    uint64_t planNanos = 0;
+    int undiscovered = 0;       // cells left unseen
+    bool lost = false;          // signal lost, or no clear start cell
+};
+
+struct BatchResult {
+    std::vector<BatchMission> missions;     // in mission order
+    int threads = 0;
+    int arenas = 0;             // worker arenas created
+    double wallMs = 0;
+};
+
+// Seed of mission 'index' in a batch seeded with 'seed'
+uint64_t batchSeed(uint64_t seed, int index);
+
+BatchResult runBatch(const BatchConfig& config);
+
+#endif // BATCH_H
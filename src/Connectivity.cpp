@@ -0,0 +1,294 @@
+#include "Connectivity.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+const int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+
+int findRoot(int* parent, int i) {
+    while (parent[i] != i) i = parent[i];
+    return i;
+}
+
+} // namespace
+
+void ConnectivityIndex::build(const GridMap& m)
+{
+    map = &m;
+    rows = m.getRows();
+    cols = m.getCols();
+    size_t cells = (size_t)rows * cols;
+    seen.assign(cells, 0);
+    searchStamp.assign(cells, 0);
+    searchGroup.assign(cells, 0);
+    searchGeneration = 0;
+    relabelled = 0;
+    fullRelabels = 0;
+    labelAll();
+}
+
+// Labels every free cell from scratch, keeping the discovered flags.
+// Works on runs of free cells read straight off the fire bit layer: runs in
+// neighbouring rows that overlap or touch diagonally are joined with a
+// union-find, then each run's label is written in one go.
+void ConnectivityIndex::labelAll()
+{
+    runs.clear();
+    const int words = map->getWordsPerRow();
+    const uint64_t lastWordMask = (cols & 63) ? (1ULL << (cols & 63)) - 1 : ~0ULL;
+    size_t prevBegin = 0;
+    for (int r = 0; r < rows; r++) {
+        const uint64_t* fire = map->fireRow(r);
+        size_t rowBegin = runs.size();
+        int runStart = -1;
+        for (int w = 0; w < words; w++) {
+            uint64_t free = ~fire[w];
+            if (w == words - 1) free &= lastWordMask;
+            int pos = 0;
+            while (pos < 64) {
+                if (runStart < 0) {
+                    uint64_t rest = free >> pos;
+                    if (!rest) break;
+                    pos += __builtin_ctzll(rest);
+                    runStart = w * 64 + pos;
+                }
+                uint64_t blocked = ~free >> pos;
+                if (!blocked) break;    // the run goes on into the next word
+                pos += __builtin_ctzll(blocked);
+                runs.push_back({r, runStart, w * 64 + pos, (int)runs.size()});
+                runStart = -1;
+            }
+        }
+        if (runStart >= 0) runs.push_back({r, runStart, cols, (int)runs.size()});
+
+        // Join with the previous row's runs; both lists are sorted by column
+        size_t p = prevBegin;
+        for (size_t i = rowBegin; i < runs.size(); i++) {
+            while (p < rowBegin && runs[p].end < runs[i].begin) p++;
+            for (size_t q = p; q < rowBegin && runs[q].begin <= runs[i].end; q++) {
+                int a = findRun((int)i), b = findRun((int)q);
+                if (a != b) runs[std::max(a, b)].parent = std::min(a, b);
+            }
+        }
+        prevBegin = rowBegin;
+    }
+
+    label.assign((size_t)rows * cols, -1);
+    undiscovered.clear();
+    runLabel.assign(runs.size(), -1);
+    for (size_t i = 0; i < runs.size(); i++) {
+        int root = findRun((int)i);
+        if (runLabel[root] < 0) {
+            runLabel[root] = (int)undiscovered.size();
+            undiscovered.push_back(0);
+        }
+        int id = runLabel[root];
+        size_t base = (size_t)runs[i].row * cols;
+        int count = 0;
+        for (int c = runs[i].begin; c < runs[i].end; c++) {
+            label[base + c] = id;
+            count += !seen[base + c];
+        }
+        undiscovered[id] += count;
+    }
+    liveComponents = (int)undiscovered.size();
+}
+
+int ConnectivityIndex::findRun(int i)
+{
+    while (runs[i].parent != i) {
+        runs[i].parent = runs[runs[i].parent].parent;
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+void ConnectivityIndex::markDiscovered(int r, int c)
+{
+    size_t cell = (size_t)r * cols + c;
+    if (seen[cell]) return;
+    seen[cell] = 1;
+    if (label[cell] >= 0) undiscovered[label[cell]]--;
+}
+
+bool ConnectivityIndex::reachableUndiscovered(int r, int c) const
+{
+    size_t cell = (size_t)r * cols + c;
+    if (!seen[cell]) return true;
+    int comp = label[cell];
+    if (comp >= 0) return undiscovered[comp] > 0;
+    // The drone's own cell is on fire: it can still leave into any neighbour
+    for (auto &d : DIR) {
+        int nr = r + d[0], nc = c + d[1];
+        if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+        int n = label[(size_t)nr * cols + nc];
+        if (n >= 0 && undiscovered[n] > 0) return true;
+    }
+    return false;
+}
+
+bool ConnectivityIndex::reachable(int fromR, int fromC, int toR, int toC) const
+{
+    if (fromR == toR && fromC == toC) return true;
+    int target = label[(size_t)toR * cols + toC];
+    if (target < 0) return false;
+    int comp = label[(size_t)fromR * cols + fromC];
+    if (comp >= 0) return comp == target;
+    for (auto &d : DIR) {
+        int nr = fromR + d[0], nc = fromC + d[1];
+        if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+        if (label[(size_t)nr * cols + nc] == target) return true;
+    }
+    return false;
+}
+
+void ConnectivityIndex::cellsBlocked(const std::vector<int>& cells)
+{
+    // Once more than ~1/256 of the map burns at once, the split searches
+    // (a couple of microseconds per burnt cell on big fronts) lose to
+    // relabelling the whole map (a few nanoseconds per cell)
+    size_t mapCells = (size_t)rows * cols;
+    if (cells.size() * 256 > mapCells) {
+        fullRelabels++;
+        labelAll();
+        return;
+    }
+
+    // One cell at a time: cells later in the list still count as free, so
+    // every split shows up as a local split around some removed cell.
+    // The searches may not visit more cells than a full relabel would.
+    workLeft = mapCells / 2;
+    for (int cell : cells) {
+        removeCell(cell);
+        if (workLeft == 0) {
+            fullRelabels++;
+            labelAll();
+            return;
+        }
+    }
+}
+
+void ConnectivityIndex::removeCell(int cell)
+{
+    int comp = label[cell];
+    if (comp < 0) return;
+    label[cell] = -1;
+    if (!seen[cell]) undiscovered[comp]--;
+
+    // Free neighbours, grouped by which of them touch each other directly
+    int r = cell / cols, c = cell - r * cols;
+    int offsets[8][2];
+    int cellsAround[8];
+    int parent[8];
+    int n = 0;
+    for (auto &d : DIR) {
+        int nr = r + d[0], nc = c + d[1];
+        if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+        int next = nr * cols + nc;
+        if (label[next] != comp) continue;
+        offsets[n][0] = d[0];
+        offsets[n][1] = d[1];
+        cellsAround[n] = next;
+        parent[n] = n;
+        n++;
+    }
+    if (n == 0) {
+        liveComponents--;   // the component was this one cell
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (std::abs(offsets[i][0] - offsets[j][0]) <= 1 &&
+                std::abs(offsets[i][1] - offsets[j][1]) <= 1) {
+                parent[findRoot(parent, j)] = findRoot(parent, i);
+            }
+        }
+    }
+    int seeds[4];
+    int groups = 0;
+    for (int i = 0; i < n; i++) {
+        if (findRoot(parent, i) == i) seeds[groups++] = cellsAround[i];
+    }
+    if (groups > 1) {
+        splitSearch(comp, seeds, groups);
+    }
+}
+
+// Grows one BFS per neighbour group, a cell each in turn. Groups whose
+// searches meet are joined; a group (or joined set) whose search runs out
+// of cells first is cut off and gets a new component id. Stops when one set
+// is left - it keeps the old id, so the work is bounded by the smaller pieces.
+void ConnectivityIndex::splitSearch(int comp, const int* seeds, int groups)
+{
+    if (++searchGeneration == 0) {
+        std::fill(searchStamp.begin(), searchStamp.end(), 0);
+        searchGeneration = 1;
+    }
+    int set[4];
+    size_t head[4];
+    bool cutOff[4] = {false, false, false, false};
+    for (int i = 0; i < groups; i++) {
+        set[i] = i;
+        head[i] = 0;
+        queues[i].clear();
+        queues[i].push_back(seeds[i]);
+        searchStamp[seeds[i]] = searchGeneration;
+        searchGroup[seeds[i]] = (uint8_t)i;
+    }
+    int liveSets = groups;
+
+    while (liveSets > 1) {
+        for (int i = 0; i < groups && liveSets > 1; i++) {
+            if (cutOff[findRoot(set, i)] || head[i] == queues[i].size()) continue;
+            if (workLeft == 0) return;    // the caller relabels everything
+            workLeft--;
+            int cell = queues[i][head[i]++];
+            int r = cell / cols, c = cell - r * cols;
+            for (auto &d : DIR) {
+                int nr = r + d[0], nc = c + d[1];
+                if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+                int next = nr * cols + nc;
+                if (label[next] != comp) continue;
+                if (searchStamp[next] != searchGeneration) {
+                    searchStamp[next] = searchGeneration;
+                    searchGroup[next] = (uint8_t)i;
+                    queues[i].push_back(next);
+                    continue;
+                }
+                int a = findRoot(set, i), b = findRoot(set, searchGroup[next]);
+                if (a != b) {
+                    set[b] = a;
+                    liveSets--;
+                    if (liveSets == 1) break;
+                }
+            }
+        }
+
+        // A set with no cells left to expand is a piece of its own
+        for (int s = 0; s < groups && liveSets > 1; s++) {
+            if (findRoot(set, s) != s || cutOff[s]) continue;
+            bool exhausted = true;
+            for (int i = 0; i < groups; i++) {
+                if (findRoot(set, i) == s && head[i] != queues[i].size()) exhausted = false;
+            }
+            if (!exhausted) continue;
+            int id = (int)undiscovered.size();
+            int count = 0;
+            for (int i = 0; i < groups; i++) {
+                if (findRoot(set, i) != s) continue;
+                for (int cell : queues[i]) {
+                    label[cell] = id;
+                    if (!seen[cell]) count++;
+                }
+                relabelled += queues[i].size();
+            }
+            undiscovered.push_back(count);
+            undiscovered[comp] -= count;
+            liveComponents++;
+            cutOff[s] = true;
+            liveSets--;
+        }
+    }
+}
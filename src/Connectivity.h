@@ -0,0 +1,76 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <vector>
+#include <cstdint>
+
+#include "GridMap.h"
+
+// Connected components of the non-fire cells (8-connected, like the
+// planners) with the number of undiscovered cells in each, so "can the drone
+// still reach anything undiscovered?" is a lookup instead of a flood fill.
+//
+// Fire only ever removes free cells, so components can only split. After a
+// cell burns, the free cells around it are checked for a local split first;
+// only if they fall into separate groups do searches run from each group at
+// the same pace, and the first one to run out of cells has found a piece
+// that broke off. Only that piece - the smaller side - is relabelled. When
+// a large burn makes those searches cost more than labelling the whole map
+// again, it does that instead.
+class ConnectivityIndex {
+public:
+    // Labels every free cell of 'map' and marks all cells undiscovered.
+    // The map must stay alive while the index is used.
+    void build(const GridMap& map);
+
+    // The drone has seen (r, c).
+    void markDiscovered(int r, int c);
+
+    // Cells (row * cols + col) that caught fire, e.g.
+    // GridMap::getLastIgnited() after spreadFires.
+    void cellsBlocked(const std::vector<int>& cells);
+
+    // Same answer as anyReachableUndiscovered(), in O(1).
+    bool reachableUndiscovered(int r, int c) const;
+
+    // True if a path from (fromR, fromC) to the free cell (toR, toC) exists,
+    // i.e. whether a planner query can succeed.
+    bool reachable(int fromR, int fromC, int toR, int toC) const;
+
+    int componentOf(int r, int c) const { return label[(size_t)r * cols + c]; }
+    int componentCount() const { return liveComponents; }
+    uint64_t getRelabelled() const { return relabelled; }
+    uint64_t getFullRelabels() const { return fullRelabels; }
+
+private:
+    void labelAll();
+    int findRun(int i);
+    void removeCell(int cell);
+    void splitSearch(int comp, const int* seeds, int groups);
+
+    const GridMap* map = nullptr;
+    int rows = 0, cols = 0;
+    std::vector<int> label;          // component id, -1 for fire
+    std::vector<char> seen;          // discovered flag per cell
+    std::vector<int> undiscovered;   // per component id
+    int liveComponents = 0;
+    uint64_t relabelled = 0;         // cells moved to a new component so far
+    uint64_t fullRelabels = 0;
+    size_t workLeft = 0;             // split search budget of the current batch
+
+    // Split search scratch: a stamp per cell for the current search and the
+    // group that reached it
+    std::vector<uint32_t> searchStamp;
+    std::vector<uint8_t> searchGroup;
+    uint32_t searchGeneration = 0;
+    std::vector<int> queues[4];
+
+    // Free-cell runs of labelAll(), joined through 'parent'
+    struct Run {
+        int row, begin, end, parent;
+    };
+    std::vector<Run> runs;
+    std::vector<int> runLabel;
+};
+
+#endif // CONNECTIVITY_H
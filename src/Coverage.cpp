@@ -0,0 +1,90 @@
+#include "Coverage.h"
+
+#include <algorithm>
+
+void CoverageLayer::reset(int r, int c)
+{
+    rows = r;
+    cols = c;
+    wordsPerRow = (cols + 63) / 64;
+    size_t words = (size_t)rows * wordsPerRow;
+    bits.reset(new std::atomic<uint64_t>[words]);
+    for (size_t i = 0; i < words; i++) bits[i].store(0, std::memory_order_relaxed);
+    undiscovered.store(rows * cols, std::memory_order_relaxed);
+}
+
+bool CoverageLayer::mark(int r, int c)
+{
+    uint64_t bit = 1ULL << (c & 63);
+    std::atomic<uint64_t>& w = word(r, c >> 6);
+    if (w.load(std::memory_order_relaxed) & bit) return false;
+    if (w.fetch_or(bit, std::memory_order_relaxed) & bit) return false;
+    undiscovered.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool CoverageLayer::anyUndiscovered(int r0, int c0, int r1, int c1) const
+{
+    r0 = std::max(r0, 0);
+    c0 = std::max(c0, 0);
+    r1 = std::min(r1, rows - 1);
+    c1 = std::min(c1, cols - 1);
+    if (r0 > r1 || c0 > c1) return false;
+    int w0 = c0 >> 6, w1 = c1 >> 6;
+    for (int r = r0; r <= r1; r++) {
+        for (int w = w0; w <= w1; w++) {
+            uint64_t mask = bitRange(w == w0 ? c0 & 63 : 0, w == w1 ? c1 & 63 : 63);
+            if (~word(r, w).load(std::memory_order_relaxed) & mask) return true;
+        }
+    }
+    return false;
+}
+
+void CoverageLayer::columnCounts(std::vector<int>& counts) const
+{
+    counts.assign(cols, 0);
+    for (int r = 0; r < rows; r++) {
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t open = ~word(r, w).load(std::memory_order_relaxed);
+            if (w == wordsPerRow - 1 && (cols & 63)) open &= (1ULL << (cols & 63)) - 1;
+            while (open) {
+                counts[w * 64 + __builtin_ctzll(open)]++;
+                open &= open - 1;
+            }
+        }
+    }
+}
+
+void DiscoveredLayer::reset(int r, int c)
+{
+    rows = r;
+    cols = c;
+    wordsPerRow = (cols + 63) / 64;
+    bits.assign((size_t)rows * wordsPerRow, 0);
+    undiscovered = rows * cols;
+}
+
+int DiscoveredLayer::markSpan(int r, int c0, int c1)
+{
+    int before = undiscovered;
+    int w0 = c0 >> 6, w1 = c1 >> 6;
+    for (int w = w0; w <= w1; w++) {
+        mark(r, w, bitRange(w == w0 ? c0 & 63 : 0, w == w1 ? c1 & 63 : 63));
+    }
+    return before - undiscovered;
+}
+
+int DiscoveredLayer::countUndiscovered(int r, int c0, int c1) const
+{
+    c0 = std::max(c0, 0);
+    c1 = std::min(c1, cols - 1);
+    if (r < 0 || r >= rows || c0 > c1) return 0;
+    const uint64_t* words = row(r);
+    int w0 = c0 >> 6, w1 = c1 >> 6;
+    int count = 0;
+    for (int w = w0; w <= w1; w++) {
+        uint64_t mask = bitRange(w == w0 ? c0 & 63 : 0, w == w1 ? c1 & 63 : 63);
+        count += __builtin_popcountll(~words[w] & mask);
+    }
+    return count;
+}
@@ -0,0 +1,85 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bits lo..hi (inclusive, 0..63) of a word
+inline uint64_t bitRange(int lo, int hi) {
+    uint64_t upper = hi == 63 ? ~0ULL : (1ULL << (hi + 1)) - 1;
+    return upper & ~((1ULL << lo) - 1);
+}
+
+// Discovered layer shared by several drones: one bit per cell, each row
+// padded to whole 64-bit words like GridMap's fire layer. Drones mark cells
+// concurrently with atomic fetch_or; window tests read a word at a time.
+class CoverageLayer {
+public:
+    void reset(int rows, int cols);
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getUndiscovered() const { return undiscovered.load(std::memory_order_relaxed); }
+
+    // Marks the cell discovered; true if this call was the first
+    bool mark(int r, int c);
+    bool isDiscovered(int r, int c) const {
+        return (word(r, c >> 6).load(std::memory_order_relaxed) >> (c & 63)) & 1;
+    }
+
+    // True if any cell of [r0, r1] x [c0, c1], clipped to the map, is undiscovered
+    bool anyUndiscovered(int r0, int c0, int r1, int c1) const;
+
+    // Undiscovered cells in each column
+    void columnCounts(std::vector<int>& counts) const;
+
+private:
+    std::atomic<uint64_t>& word(int r, int w) const { return bits[(size_t)r * wordsPerRow + w]; }
+
+    int rows = 0, cols = 0, wordsPerRow = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> bits;
+    std::atomic<int> undiscovered{0};
+};
+
+// One drone's discovered layer: the same layout in plain words, marked a
+// word at a time, so a perception update costs a few word operations per
+// row of the sensor footprint rather than one per cell.
+class DiscoveredLayer {
+public:
+    // All cells undiscovered; keeps the buffer when the size allows
+    void reset(int rows, int cols);
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getWordsPerRow() const { return wordsPerRow; }
+    int getUndiscovered() const { return undiscovered; }
+
+    bool isDiscovered(int r, int c) const {
+        return (bits[(size_t)r * wordsPerRow + (c >> 6)] >> (c & 63)) & 1;
+    }
+    const uint64_t* row(int r) const { return bits.data() + (size_t)r * wordsPerRow; }
+
+    // Marks the cells of 'mask' in word 'w' of row 'r' (no bits past the
+    // last column) and returns the ones that were undiscovered
+    uint64_t mark(int r, int w, uint64_t mask) {
+        uint64_t& word = bits[(size_t)r * wordsPerRow + w];
+        uint64_t fresh = mask & ~word;
+        word |= fresh;
+        undiscovered -= __builtin_popcountll(fresh);
+        return fresh;
+    }
+    // Marks columns c0..c1 of row r; returns how many were undiscovered
+    int markSpan(int r, int c0, int c1);
+
+    // Undiscovered cells among columns c0..c1 of row r, clipped to the map
+    int countUndiscovered(int r, int c0, int c1) const;
+
+private:
+    int rows = 0, cols = 0, wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+    int undiscovered = 0;
+};
+
+#endif // COVERAGE_H
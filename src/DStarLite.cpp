@@ -0,0 +1,236 @@
+#include "DStarLite.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+const uint32_t INF = 0xFFFFFFFFu;
+const uint32_t STRAIGHT_COST = 10;
+const uint32_t DIAGONAL_COST = 14;
+const int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+
+inline uint32_t addCost(uint32_t a, uint32_t b) {
+    uint64_t sum = (uint64_t)a + b;
+    return sum >= INF ? INF : (uint32_t)sum;
+}
+
+} // namespace
+
+DStarLite::Node& DStarLite::node(int cell) {
+    Node& n = nodes[cell];
+    if (n.stamp != generation) {
+        n.stamp = generation;
+        n.g = INF;
+        n.rhs = INF;
+        n.open = false;
+    }
+    return n;
+}
+
+// Cost of moving from (fr, fc) into the neighbouring cell (tr, tc)
+uint32_t DStarLite::stepCost(int fr, int fc, int tr, int tc) const {
+    if (map->isFire(tr, tc)) return INF;
+    return (fr != tr && fc != tc) ? DIAGONAL_COST : STRAIGHT_COST;
+}
+
+// Octile distance from the current start
+uint32_t DStarLite::heuristic(int cell) const {
+    int r = cell / cols, c = cell - r * cols;
+    int sr = start / cols, sc = start - sr * cols;
+    uint32_t dr = (uint32_t)std::abs(r - sr);
+    uint32_t dc = (uint32_t)std::abs(c - sc);
+    return dr < dc ? DIAGONAL_COST * dr + STRAIGHT_COST * (dc - dr)
+                   : DIAGONAL_COST * dc + STRAIGHT_COST * (dr - dc);
+}
+
+DStarLite::Key DStarLite::calculateKey(int cell) {
+    Node& n = node(cell);
+    uint32_t m = std::min(n.g, n.rhs);
+    if (m == INF) return {UINT64_MAX, INF};
+    return {(uint64_t)m + heuristic(cell) + km, m};
+}
+
+// Cheapest way on from 'cell': min over neighbours of step cost + g
+uint32_t DStarLite::bestSuccessor(int cell, int* next) {
+    int r = cell / cols, c = cell - r * cols;
+    uint32_t best = INF;
+    for (auto &d : DIR) {
+        int nr = r + d[0], nc = c + d[1];
+        if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+        int n = nr * cols + nc;
+        uint32_t cost = addCost(stepCost(r, c, nr, nc), g(n));
+        if (cost < best) {
+            best = cost;
+            if (next) *next = n;
+        }
+    }
+    return best;
+}
+
+void DStarLite::pushOpen(int cell, const Key& key) {
+    Node& n = node(cell);
+    n.open = true;
+    n.key = key;
+    heap.push_back({key, cell});
+    std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+}
+
+void DStarLite::updateVertex(int cell) {
+    Node& n = node(cell);
+    if (n.g != n.rhs) {
+        pushOpen(cell, calculateKey(cell));
+    } else {
+        n.open = false;   // its queue entry, if any, is now stale
+    }
+}
+
+// Drops queue entries that were superseded or belong to closed nodes
+void DStarLite::cleanTop() {
+    while (!heap.empty()) {
+        const Entry& top = heap.front();
+        Node& n = node(top.cell);
+        if (n.open && n.key == top.key) return;
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        heap.pop_back();
+    }
+}
+
+void DStarLite::computeShortestPath() {
+    while (true) {
+        cleanTop();
+        if (heap.empty()) break;
+        Key startKey = calculateKey(start);
+        Node& s = node(start);
+        if (!(heap.front().key < startKey) && s.rhs == s.g) break;
+
+        Entry top = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        heap.pop_back();
+        int u = top.cell;
+        Node& n = node(u);
+        n.open = false;
+        stats.expanded++;
+
+        Key newKey = calculateKey(u);
+        int r = u / cols, c = u - r * cols;
+        if (top.key < newKey) {
+            // km grew since it was queued: requeue with the current key
+            pushOpen(u, newKey);
+        } else if (n.g > n.rhs) {
+            // Overconsistent: take the new cost, neighbours may improve through it
+            n.g = n.rhs;
+            for (auto &d : DIR) {
+                int nr = r + d[0], nc = c + d[1];
+                if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+                int s = nr * cols + nc;
+                if (s == goal) continue;
+                uint32_t viaU = addCost(stepCost(nr, nc, r, c), n.g);
+                Node& ns = node(s);
+                if (viaU < ns.rhs) {
+                    ns.rhs = viaU;
+                    updateVertex(s);
+                }
+            }
+        } else {
+            // Underconsistent: its old cost is gone; neighbours that relied
+            // on it (and u itself) look for their next best successor
+            uint32_t oldG = n.g;
+            n.g = INF;
+            if (u != goal) n.rhs = bestSuccessor(u, nullptr);
+            updateVertex(u);
+            for (auto &d : DIR) {
+                int nr = r + d[0], nc = c + d[1];
+                if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+                int s = nr * cols + nc;
+                if (s == goal) continue;
+                Node& ns = node(s);
+                if (ns.rhs != INF && ns.rhs == addCost(stepCost(nr, nc, r, c), oldG)) {
+                    ns.rhs = bestSuccessor(s, nullptr);
+                    updateVertex(s);
+                }
+            }
+        }
+    }
+}
+
+void DStarLite::reset(const GridMap& m, int startR, int startC, int goalR, int goalC) {
+    map = &m;
+    if (rows != m.getRows() || cols != m.getCols()) {
+        rows = m.getRows();
+        cols = m.getCols();
+        nodes.assign((size_t)rows * cols, Node{0, INF, INF, false, {0, 0}});
+        generation = 0;
+    }
+    if (++generation == 0) {
+        for (Node& n : nodes) n.stamp = 0;
+        generation = 1;
+    }
+    heap.clear();
+    start = lastStart = startR * cols + startC;
+    goal = goalR * cols + goalC;
+    km = 0;
+    planned = false;
+    stats.resets++;
+
+    node(goal).rhs = 0;
+    pushOpen(goal, calculateKey(goal));
+}
+
+void DStarLite::moveStart(int r, int c) {
+    start = r * cols + c;
+    if (start == lastStart) return;
+    // Keys already queued used the old start; km keeps them comparable
+    int lr = lastStart / cols, lc = lastStart - lr * cols;
+    uint32_t dr = (uint32_t)std::abs(r - lr);
+    uint32_t dc = (uint32_t)std::abs(c - lc);
+    km += dr < dc ? DIAGONAL_COST * dr + STRAIGHT_COST * (dc - dr)
+                  : DIAGONAL_COST * dc + STRAIGHT_COST * (dr - dc);
+    lastStart = start;
+}
+
+void DStarLite::cellsBlocked(const std::vector<int>& cells) {
+    if (!map) return;
+    for (int v : cells) {
+        stats.changedCells++;
+        // Only the edges into v changed, so only neighbours whose best
+        // successor was v need a new one
+        int r = v / cols, c = v - r * cols;
+        uint32_t gv = g(v);
+        if (gv == INF) continue;
+        for (auto &d : DIR) {
+            int nr = r + d[0], nc = c + d[1];
+            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+            int s = nr * cols + nc;
+            if (s == goal) continue;
+            uint32_t oldCost = (d[0] && d[1]) ? DIAGONAL_COST : STRAIGHT_COST;
+            Node& ns = node(s);
+            if (ns.rhs == addCost(oldCost, gv)) {
+                ns.rhs = bestSuccessor(s, nullptr);
+                updateVertex(s);
+            }
+        }
+    }
+}
+
+void DStarLite::computePath(std::vector<std::pair<int,int>>& path) {
+    path.clear();
+    if (planned) stats.repairs++;
+    planned = true;
+    computeShortestPath();
+
+    if (node(start).rhs == INF && start != goal) return;
+    size_t limit = (size_t)rows * cols;
+    int cell = start;
+    path.push_back({cell / cols, cell % cols});
+    while (cell != goal) {
+        int next = -1;
+        if (bestSuccessor(cell, &next) == INF || path.size() > limit) {
+            path.clear();
+            return;
+        }
+        cell = next;
+        path.push_back({cell / cols, cell % cols});
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef DSTARLITE_H
+#define DSTARLITE_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "GridMap.h"
+
+// Incremental planner (D* Lite, Koenig & Likhachev 2002) for one goal.
+// It searches backwards from the goal, so when the drone moves and fires
+// appear it only repairs the part of the search tree the new fire cells
+// touch instead of planning from scratch.
+//  - Same grid model as the other planners: 8-connected, octile costs
+//    (straight 10, diagonal 14), fire cells cannot be entered.
+//  - Per-cell state is stamped per reset(), so starting a new goal does not
+//    clear or reallocate anything.
+class DStarLite {
+public:
+    struct Stats {
+        uint64_t resets = 0;
+        uint64_t repairs = 0;       // computePath calls after the first for a goal
+        uint64_t expanded = 0;
+        uint64_t changedCells = 0;
+    };
+
+    // Starts planning from (startR, startC) to (goalR, goalC) on 'map'.
+    // The map must stay alive until the next reset().
+    void reset(const GridMap& map, int startR, int startC, int goalR, int goalC);
+
+    // The drone is now at (r, c).
+    void moveStart(int r, int c);
+
+    // Cells (row * cols + col) that caught fire since the last call, e.g.
+    // GridMap::getLastIgnited() after each spreadFires.
+    void cellsBlocked(const std::vector<int>& cells);
+
+    // Brings the search up to date and writes the path from the current
+    // start to the goal, or leaves 'path' empty if there is none.
+    void computePath(std::vector<std::pair<int,int>>& path);
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    // Queue priority: k1 = min(g, rhs) + h + km, then k2 = min(g, rhs)
+    struct Key {
+        uint64_t k1;
+        uint32_t k2;
+        bool operator<(const Key& o) const { return k1 < o.k1 || (k1 == o.k1 && k2 < o.k2); }
+        bool operator==(const Key& o) const { return k1 == o.k1 && k2 == o.k2; }
+    };
+    struct Node {
+        uint32_t stamp;
+        uint32_t g;
+        uint32_t rhs;
+        bool open;
+        Key key;        // key the node was last queued with
+    };
+    struct Entry {
+        Key key;
+        int cell;
+        bool operator>(const Entry& o) const { return o.key < key; }
+    };
+
+    Node& node(int cell);
+    uint32_t g(int cell) { return node(cell).g; }
+    uint32_t rhs(int cell) { return node(cell).rhs; }
+    uint32_t stepCost(int fr, int fc, int tr, int tc) const;
+    uint32_t heuristic(int cell) const;
+    Key calculateKey(int cell);
+    uint32_t bestSuccessor(int cell, int* next);
+    void updateVertex(int cell);
+    void pushOpen(int cell, const Key& key);
+    void cleanTop();
+    void computeShortestPath();
+
+    const GridMap* map = nullptr;
+    int rows = 0, cols = 0;
+    int start = -1, goal = -1, lastStart = -1;
+    uint64_t km = 0;
+    bool planned = false;
+    uint32_t generation = 0;
+    std::vector<Node> nodes;
+    std::vector<Entry> heap;
+    Stats stats;
+};
+
+#endif // DSTARLITE_H
@@ -1,37 +1,41 @@
 #include <iostream>
 #include <vector>
-#include <queue>
+#include <string>
 #include <utility>
 #include <cstdlib>
-#include <ctime>
 #include <thread>
 #include <chrono>
 #include <algorithm>
-#include <time.h>
-
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
+#include <memory>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <random>
 
 #include "GridMap.h"
-
-bool sendLine(SOCKET s, const std::string& msg) {
-    std::string withNewline = msg + "\n";
-    int totalSent = 0;
-    while (totalSent < (int)withNewline.size()) {
-        int ret = send(s, withNewline.c_str() + totalSent, (int)withNewline.size() - totalSent, 0);
-        if (ret == SOCKET_ERROR) return false;
-        totalSent += ret;
-    }
-    return true;
+#include "Mission.h"
+#include "Fleet.h"
+#include "MapFile.h"
+#include "Net.h"
+#include "Telemetry.h"
+#include "SendQueue.h"
+#include "MapRenderer.h"
+#include "MissionLog.h"
+#include "Batch.h"
+#include "Probe.h"
+
+// Sends one message; 'line' already ends in '\n'
+bool sendLine(NetSocket s, const std::string& line) {
+    PROBE_SCOPE("net.sendLine");
+    PROBE_COUNT("net.bytes", line.size());
+    return netSendAll(s, line.data(), line.size());
 }
 
-void clearScreen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    system("clear");
-#endif
+void appendInt(std::string& out, int value) {
+    char digits[12];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr);
 }
 
 void printRowSeparator(int cols) {
@@ -44,16 +48,17 @@ void printRowSeparator(int cols) {
 
 // Show the drone's local map
 void displayDroneMap(const GridMap& map,
-                     const std::vector<std::vector<bool>>& discovered,
+                     const DiscoveredLayer& discovered,
                      int droneRow, int droneCol)
 {
+    PROBE_SCOPE("render.full");
     int rows = map.getRows();
     int cols = map.getCols();
     for (int i = 0; i < rows; i++) {
         printRowSeparator(cols);
         for (int j = 0; j < cols; j++) {
             std::cout << "| ";
-            if (!discovered[i][j]) {
+            if (!discovered.isDiscovered(i, j)) {
                 std::cout << "? ";
             }
             else if (i == droneRow && j == droneCol) {
@@ -71,176 +76,613 @@ void displayDroneMap(const GridMap& map,
     printRowSeparator(cols);
 }
 
-// BFS pathfinding
-std::vector<std::pair<int,int>> getPathBFS(const GridMap& map,
-                                           int startR, int startC,
-                                           int goalR, int goalC)
-{
-    if (startR == goalR && startC == goalC) {
-        return {{startR, startC}};
+// The probe timers and counters as JSON between 'before' and 'after', in
+// builds with probes (make PROBES=1)
+void printProbes(const char* before, const char* after = "") {
+    if (!PROBES_ENABLED) return;
+    std::cout << before;
+    probeReportJson(std::cout);
+    std::cout << after;
+}
+
+// Connect to server (localhost:12345); NET_INVALID on failure
+NetSocket connectToServer() {
+    NetSocket sock = netConnect("127.0.0.1", 12345);
+    if (sock == NET_INVALID) {
+        std::cerr << "connect() failed.\n";
     }
-    int rows = map.getRows();
-    int cols = map.getCols();
-    if (map.getCell(goalR, goalC) == 'X') {
-        return {};
-    }
-    int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
-    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
-    std::vector<std::vector<std::pair<int,int>>> parent(rows, std::vector<std::pair<int,int>>(cols, {-1,-1}));
-    std::queue<std::pair<int,int>> q;
-    q.push({startR, startC});
-    visited[startR][startC] = true;
-
-    bool found = false;
-    while (!q.empty() && !found) {
-        auto [r, c] = q.front();
-        q.pop();
-        for (auto &d : DIR) {
-            int nr = r + d[0];
-            int nc = c + d[1];
-            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
-            if (visited[nr][nc] || map.getCell(nr,nc) == 'X') continue;
-            visited[nr][nc] = true;
-            parent[nr][nc] = {r, c};
-            q.push({nr, nc});
-            if (nr == goalR && nc == goalC) {
-                found = true;
-                break;
-            }
-        }
+    return sock;
+}
+
+// Introduces the drone and its grid to the station with a HELLO line and,
+// if 'binary', offers binary telemetry. Returns the version the station
+// agrees to, 0 (text) if it declines or does not answer within a second.
+// A version above 0 is confirmed to the station, which keeps reading text
+// until then. The answer is read even when only text was offered: data
+// left unread on the socket would make closing it reset the connection
+// and drop the reports the station has not read yet.
+int negotiateTelemetry(NetSocket sock, int droneId, int rows, int cols, bool binary) {
+    int offer = binary ? TELEMETRY_VERSION : 0;
+    std::string hello = "HELLO " + std::to_string(offer) + " " + std::to_string(droneId) + " " +
+                        std::to_string(rows) + " " + std::to_string(cols) + "\n";
+    if (!sendLine(sock, hello)) return 0;
+    netSetRecvTimeout(sock, 1000);
+    RecvBuffer reply;
+    std::string_view line;
+    int version = 0;
+    bool answered = true;
+    while (answered && !reply.nextLine(line)) {
+        answered = reply.fill(sock) > 0;
     }
-    if (!found) {
-        return {};
+    netSetRecvTimeout(sock, 0);
+    if (answered && line.substr(0, 6) == "HELLO ") {
+        std::from_chars(line.data() + 6, line.data() + line.size(), version);
     }
-    std::vector<std::pair<int,int>> path;
-    int cr = goalR, cc = goalC;
-    while (!(cr==startR && cc==startC)) {
-        path.push_back({cr, cc});
-        auto p = parent[cr][cc];
-        cr = p.first;
-        cc = p.second;
+    version = binary ? std::max(0, std::min(version, TELEMETRY_VERSION)) : 0;
+    if (version > 0 && !sendLine(sock, "BINARY " + std::to_string(version) + "\n")) return 0;
+    return version;
+}
+
+// Largest map file flown whole without --grid: the drone keeps several
+// bytes of state per cell
+const int MAX_MAP_GRID = 4096;
+
+// The planners number cells row * cols + col in an int
+bool gridFits(int rows, int cols) {
+    return rows > 0 && cols > 0 && (int64_t)rows * cols <= std::numeric_limits<int>::max();
+}
+
+// Command-line options. Without flags the client asks for the grid size and
+// start on stdin and animates every move, as before.
+struct Options {
+    bool help = false;
+    bool headless = false;      // no prompts, no sleeping, JSON summary at the end
+    bool offline = false;       // don't connect to the base station
+    int rows = 0, cols = 0;     // 0 = ask
+    int startRow = -1, startCol = -1;
+    bool started = false;       // --start given (else -1 -1: ask, or 0 0 for --batch)
+    bool seeded = false;        // false = pick a seed and report it
+    uint64_t seed = 0;
+    int firePercent = 10;
+    std::string mapFile;        // fires from a map file instead of at random
+    int mapTop = 0, mapLeft = 0;
+    double spreadChance = 0.02;
+    int spreadEvery = 5;
+    int renderEvery = -1;       // -1 = every move when interactive, never when headless
+    double fps = 30;            // interactive redraws per second at most, 0 = no cap
+    int reportEvery = 1;        // moves per fire report
+    bool binary = true;         // offer binary telemetry (the server may decline)
+    size_t sendQueue = 1 << 20; // bytes the sender thread can hold, 0 = send inline
+    int droneId = 1;
+    int drones = 1;             // drones sharing the map
+    int threads = 0;            // planning threads for a fleet, 0 = one per core
+    ExploreMode mode = ExploreMode::Frontier;
+    std::string planner = "astar";
+    SensorShape sensor = SensorShape::Square;
+    int range = 2;              // perception range in cells
+    std::string saveScenario;   // where to write this run's scenario
+    std::string logFile;        // mission log, empty = none
+    int batch = 0;              // missions in a batch run, 0 = fly one mission
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --headless            run without prompts or delays, print a JSON summary\n"
+              << "  --offline             don't connect to the base station\n"
+              << "  --grid ROWS COLS      grid size\n"
+              << "  --start ROW COL       drone start\n"
+              << "  --seed N              seed for the fire map and fire spread (default: a fresh one,\n"
+              << "                        reported with the results)\n"
+              << "  --scenario FILE       options from a scenario file; later flags override them\n"
+              << "  --save-scenario FILE  write this run's seed and settings as a scenario file\n"
+              << "  --log FILE            record every move, scan, spread and message (see LogReplay)\n"
+              << "  --fires PERCENT       initial fire density (default 10)\n"
+              << "  --map FILE            take the fires from a map file (see MapConvert); the grid\n"
+              << "                        defaults to the whole file, --grid flies a window of it\n"
+              << "  --map-offset ROW COL  top-left cell of that window (default 0 0)\n"
+              << "  --spread P            fire spread chance (default 0.02)\n"
+              << "  --spread-every N      moves between spread steps, 0 = never (default 5)\n"
+              << "  --render-every N      draw the map every N moves, 0 = never\n"
+              << "  --fps N               redraw the interactive map at most N times a second (default 30)\n"
+              << "  --report-every N      send the fires seen over N moves as one message (default 1)\n"
+              << "  --protocol P          binary (default, falls back to text if the server declines) or text\n"
+              << "  --send-queue BYTES    sender thread buffer, 0 = send from the flight loop (default 1048576)\n"
+              << "  --id N                drone id sent in the handshake (default 1)\n"
+              << "  --drones K            fly K drones over the same map (reports as text)\n"
+              << "  --threads N           planning threads for --drones, 0 = one per core (default 0)\n"
+              << "  --mode MODE           sweep, frontier or infogain (default frontier)\n"
+              << "  --planner NAME        bfs, astar, jps or hpa for sweep legs (default astar)\n"
+              << "  --sensor SHAPE        square, circle or los (circle, hidden behind fire) (default square)\n"
+              << "  --range N             sensor range in cells (default 2)\n"
+              << "  --batch N             fly N missions over freshly seeded maps on all cores, offline,\n"
+              << "                        and print their statistics (--threads sets the cores)\n"
+              << "Headless exit status: 0 when the map is covered, 2 if the signal was lost.\n";
+}
+
+const char* modeName(ExploreMode mode) {
+    switch (mode) {
+    case ExploreMode::Sweep:    return "sweep";
+    case ExploreMode::InfoGain: return "infogain";
+    default:                    return "frontier";
     }
-    path.push_back({startR, startC});
-    std::reverse(path.begin(), path.end());
-    return path;
 }
 
-bool anyReachableUndiscovered(const GridMap& map,
-                              const std::vector<std::vector<bool>>& discovered,
-                              int droneRow, int droneCol)
-{
-    int rows = map.getRows();
-    int cols = map.getCols();
-    std::vector<std::vector<bool>> visited(rows, std::vector<bool>(cols, false));
-    std::queue<std::pair<int,int>> q;
-    q.push({droneRow, droneCol});
-    visited[droneRow][droneCol] = true;
-
-    int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
-    while (!q.empty()) {
-        auto [r, c] = q.front();
-        q.pop();
-        if (!discovered[r][c]) {
-            return true;
-        }
-        for (auto &d : DIR) {
-            int nr = r + d[0];
-            int nc = c + d[1];
-            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
-            if (visited[nr][nc] || map.getCell(nr,nc) == 'X') continue;
-            visited[nr][nc] = true;
-            q.push({nr,nc});
+/*
+ * Scenario files hold the options that decide what a run does, so the run
+ * can be replayed bit for bit: one option per line, as on the command line
+ * without the leading dashes, '#' starting a comment.
+ *
+ *   # drone scenario
+ *   seed 42
+ *   grid 200 200
+ *   start 0 0
+ *   fires 10
+ *   spread 0.02
+ */
+bool readScenario(const std::string& path, std::vector<std::string>& args) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[Drone] cannot read scenario " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string word;
+        for (bool first = true; words >> word; first = false) {
+            args.push_back(first ? "--" + word : word);
         }
     }
-    return false;
+    return true;
+}
+
+bool writeScenario(const std::string& path, const Options& opt, int rows, int cols, int startRow, int startCol) {
+    std::ofstream out(path);
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << "# drone scenario: replay with --scenario " << path << "\n"
+        << "seed " << opt.seed << "\n"
+        << "grid " << rows << " " << cols << "\n"
+        << "start " << startRow << " " << startCol << "\n";
+    if (!opt.mapFile.empty()) {
+        out << "map " << opt.mapFile << "\n"
+            << "map-offset " << opt.mapTop << " " << opt.mapLeft << "\n";
+    } else {
+        out << "fires " << opt.firePercent << "\n";
+    }
+    out << "spread " << opt.spreadChance << "\n"
+        << "spread-every " << opt.spreadEvery << "\n"
+        << "mode " << modeName(opt.mode) << "\n"
+        << "planner " << opt.planner << "\n"
+        << "sensor " << sensorShapeName(opt.sensor) << "\n"
+        << "range " << opt.range << "\n"
+        << "drones " << opt.drones << "\n";
+    return (bool)out;
 }
 
-// When the drone first "sees" a new fire cell, we send "FIRE r c" to the server.
-void discoverCells(const GridMap& map,
-                   std::vector<std::vector<bool>>& discovered,
-                   int droneRow, int droneCol,
-                   SOCKET sock)
-{
-    int rows = map.getRows();
-    int cols = map.getCols();
-    int perceptionRange = 2;
-
-    for (int dr = -perceptionRange; dr <= perceptionRange; dr++) {
-        for (int dc = -perceptionRange; dc <= perceptionRange; dc++) {
-            int rr = droneRow + dr;
-            int cc = droneCol + dc;
-            if (rr >= 0 && rr < rows && cc >= 0 && cc < cols) {
-                // Mark discovered
-                if (!discovered[rr][cc]) {
-                    discovered[rr][cc] = true;
-                    if (map.getCell(rr, cc) == 'X') {
-                        // We found a new fire => notify server
-                        std::string msg = "FIRE " + std::to_string(rr) + " " + std::to_string(cc);
-                        sendLine(sock, msg);
-                    }
-                }
+// Scenario files may name other scenario files, this many deep
+const int MAX_SCENARIO_DEPTH = 4;
+
+bool parseArgs(const std::vector<std::string>& args, Options& opt, int depth) {
+    int argc = (int)args.size();
+    for (int i = 0; i < argc; i++) {
+        const std::string& arg = args[i];
+        // Number of values the flag still has on the command line
+        auto values = [&](int n) { return i + n < argc; };
+        if (arg == "--help" || arg == "-h") {
+            opt.help = true;
+            return true;
+        } else if (arg == "--headless") {
+            opt.headless = true;
+        } else if (arg == "--offline") {
+            opt.offline = true;
+        } else if (arg == "--grid" && values(2)) {
+            opt.rows = std::atoi(args[++i].c_str());
+            opt.cols = std::atoi(args[++i].c_str());
+            if (opt.rows <= 0 || opt.cols <= 0) return false;
+        } else if (arg == "--start" && values(2)) {
+            opt.started = true;
+            opt.startRow = std::atoi(args[++i].c_str());
+            opt.startCol = std::atoi(args[++i].c_str());
+        } else if (arg == "--seed" && values(1)) {
+            opt.seeded = true;
+            opt.seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+        } else if (arg == "--scenario" && values(1)) {
+            std::vector<std::string> scenario;
+            if (depth >= MAX_SCENARIO_DEPTH || !readScenario(args[++i], scenario) ||
+                !parseArgs(scenario, opt, depth + 1)) {
+                return false;
             }
+        } else if (arg == "--save-scenario" && values(1)) {
+            opt.saveScenario = args[++i];
+        } else if (arg == "--log" && values(1)) {
+            opt.logFile = args[++i];
+        } else if (arg == "--fires" && values(1)) {
+            opt.firePercent = std::atoi(args[++i].c_str());
+        } else if (arg == "--map" && values(1)) {
+            opt.mapFile = args[++i];
+        } else if (arg == "--map-offset" && values(2)) {
+            opt.mapTop = std::atoi(args[++i].c_str());
+            opt.mapLeft = std::atoi(args[++i].c_str());
+        } else if (arg == "--spread" && values(1)) {
+            opt.spreadChance = std::atof(args[++i].c_str());
+        } else if (arg == "--spread-every" && values(1)) {
+            opt.spreadEvery = std::atoi(args[++i].c_str());
+        } else if (arg == "--render-every" && values(1)) {
+            opt.renderEvery = std::atoi(args[++i].c_str());
+        } else if (arg == "--fps" && values(1)) {
+            opt.fps = std::atof(args[++i].c_str());
+        } else if (arg == "--report-every" && values(1)) {
+            opt.reportEvery = std::atoi(args[++i].c_str());
+            if (opt.reportEvery <= 0) return false;
+        } else if (arg == "--protocol" && values(1)) {
+            std::string protocol = args[++i];
+            if (protocol == "binary") opt.binary = true;
+            else if (protocol == "text") opt.binary = false;
+            else return false;
+        } else if (arg == "--send-queue" && values(1)) {
+            opt.sendQueue = (size_t)std::strtoull(args[++i].c_str(), nullptr, 10);
+        } else if (arg == "--id" && values(1)) {
+            opt.droneId = std::atoi(args[++i].c_str());
+        } else if (arg == "--drones" && values(1)) {
+            opt.drones = std::max(1, std::atoi(args[++i].c_str()));
+        } else if (arg == "--threads" && values(1)) {
+            opt.threads = std::max(0, std::atoi(args[++i].c_str()));
+        } else if (arg == "--mode" && values(1)) {
+            std::string mode = args[++i];
+            if (mode == "sweep") opt.mode = ExploreMode::Sweep;
+            else if (mode == "frontier") opt.mode = ExploreMode::Frontier;
+            else if (mode == "infogain") opt.mode = ExploreMode::InfoGain;
+            else return false;
+        } else if (arg == "--planner" && values(1)) {
+            opt.planner = args[++i];
+            if (!makePlanner(opt.planner)) return false;
+        } else if (arg == "--sensor" && values(1)) {
+            if (!parseSensorShape(args[++i], opt.sensor)) return false;
+        } else if (arg == "--range" && values(1)) {
+            opt.range = std::atoi(args[++i].c_str());
+            if (opt.range < 0) return false;
+        } else if (arg == "--batch" && values(1)) {
+            opt.batch = std::atoi(args[++i].c_str());
+            if (opt.batch <= 0) return false;
+        } else {
+            return false;
         }
     }
+    return true;
 }
 
-int main() {
-    // Initialize Winsock
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
-        std::cerr << "WSAStartup failed.\n";
-        return 1;
+bool parseOptions(int argc, char** argv, Options& opt) {
+    if (!parseArgs(std::vector<std::string>(argv + 1, argv + argc), opt, 0)) return false;
+    if (opt.help) return true;
+    if (opt.started && (opt.startRow < 0 || opt.startCol < 0)) {
+        std::cerr << "--start needs a row and a column of 0 or more\n";
+        return false;
+    }
+    if (opt.rows > 0 && !gridFits(opt.rows, opt.cols)) {
+        std::cerr << "--grid may have at most " << std::numeric_limits<int>::max() << " cells\n";
+        return false;
+    }
+    if (opt.batch > 0) {
+        if (opt.rows == 0) {
+            std::cerr << "--batch needs --grid\n";
+            return false;
+        }
+        if (!opt.started) opt.startRow = opt.startCol = 0;
+        if (opt.startRow >= opt.rows || opt.startCol >= opt.cols) {
+            std::cerr << "--start must lie on the --grid\n";
+            return false;
+        }
+    }
+    if (opt.headless && ((opt.rows == 0 && opt.mapFile.empty()) || !opt.started)) {
+        std::cerr << "--headless needs --grid (or --map) and --start\n";
+        return false;
     }
+    // Fleet drones share a layer marked square by square
+    if (opt.drones > 1 && opt.sensor != SensorShape::Square) {
+        std::cerr << "--drones needs the square sensor\n";
+        return false;
+    }
+    // Binary telemetry follows one drone's view of the map
+    if (opt.drones > 1) opt.binary = false;
+    if (opt.renderEvery < 0) opt.renderEvery = opt.headless ? 0 : 1;
+    return true;
+}
 
-    // Create client socket
-    SOCKET sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock == INVALID_SOCKET) {
-        std::cerr << "socket() failed.\n";
-        WSACleanup();
-        return 1;
+// --batch: many missions, no network and no map on screen. Mission i flies
+// the map of seed batchSeed(seed, i); the longest one is reported so it can
+// be flown again alone.
+int runBatchMode(const Options& opt) {
+    BatchConfig config;
+    config.missions = opt.batch;
+    config.rows = opt.rows;
+    config.cols = opt.cols;
+    config.startRow = opt.startRow;
+    config.startCol = opt.startCol;
+    config.firePercent = opt.firePercent;
+    config.seed = opt.seed;
+    config.threads = opt.threads;
+    config.mission.mode = opt.mode;
+    config.mission.planner = opt.planner;
+    config.mission.spreadChance = opt.spreadChance;
+    config.mission.spreadEvery = opt.spreadEvery;
+    config.mission.sensor = opt.sensor;
+    config.mission.perceptionRange = opt.range;
+    BatchResult result = runBatch(config);
+
+    const std::vector<BatchMission>& missions = result.missions;
+    std::vector<uint64_t> steps;
+    steps.reserve(missions.size());
+    uint64_t lost = 0;
+    double coverage = 0, fires = 0, planMs = 0;
+    size_t longest = 0;
+    for (size_t i = 0; i < missions.size(); i++) {
+        const BatchMission& m = missions[i];
+        steps.push_back(m.steps);
+        lost += m.lost;
+        coverage += 1.0 - (double)m.undiscovered / ((double)opt.rows * opt.cols);
+        fires += m.firesFound;
+        planMs += m.planNanos / 1e6;
+        if (m.steps > missions[longest].steps) longest = i;
+    }
+    std::sort(steps.begin(), steps.end());
+    double n = (double)missions.size();
+    auto percentile = [&](double p) { return steps[std::min(steps.size() - 1, (size_t)(p * steps.size()))]; };
+    double stepsMean = 0;
+    for (uint64_t s : steps) stepsMean += s;
+    stepsMean /= n;
+    double perSec = result.wallMs > 0 ? n * 1000 / result.wallMs : 0.0;
+    const BatchMission& worst = missions[longest];
+
+    if (opt.headless) {
+        std::cout << "{\"rows\":" << opt.rows << ",\"cols\":" << opt.cols
+                  << ",\"mode\":\"" << modeName(opt.mode) << "\""
+                  << ",\"sensor\":\"" << sensorShapeName(opt.sensor) << "\",\"range\":" << opt.range
+                  << ",\"missions\":" << missions.size()
+                  << ",\"threads\":" << result.threads
+                  << ",\"seed\":" << opt.seed
+                  << ",\"signalLost\":" << lost
+                  << ",\"signalLostRate\":" << lost / n
+                  << ",\"stepsMean\":" << stepsMean
+                  << ",\"stepsP50\":" << percentile(0.50)
+                  << ",\"stepsP90\":" << percentile(0.90)
+                  << ",\"stepsP99\":" << percentile(0.99)
+                  << ",\"stepsMax\":" << steps.back()
+                  << ",\"coverageMean\":" << coverage / n
+                  << ",\"firesFoundMean\":" << fires / n
+                  << ",\"planningMsMean\":" << planMs / n
+                  << ",\"longestSeed\":" << worst.seed
+                  << ",\"longestStart\":[" << worst.startRow << "," << worst.startCol << "]"
+                  << ",\"wallMs\":" << result.wallMs
+                  << ",\"missionsPerSec\":" << perSec;
+        printProbes(",\"probes\":");
+        std::cout << "}\n";
+        return 0;
     }
 
-    // Connect to server (localhost:12345)
-    sockaddr_in servAddr;
-    memset(&servAddr, 0, sizeof(servAddr));
-    servAddr.sin_family = AF_INET;
-    servAddr.sin_port   = htons(12345);
+    std::cout << "[Drone] " << missions.size() << " missions on a " << opt.rows << " x " << opt.cols
+              << " grid (" << modeName(opt.mode) << ", " << opt.firePercent << "% fires), batch seed "
+              << opt.seed << ", " << result.threads << " threads\n"
+              << "  signal lost: " << lost << " (" << 100 * lost / n << "%)\n"
+              << "  steps: mean " << stepsMean << ", p50 " << percentile(0.50) << ", p90 "
+              << percentile(0.90) << ", p99 " << percentile(0.99) << ", max " << steps.back() << "\n"
+              << "  coverage " << 100 * coverage / n << "%, fires found " << fires / n
+              << ", planning " << planMs / n << " ms per mission\n"
+              << "  longest: --seed " << worst.seed << " --start " << worst.startRow << " "
+              << worst.startCol << "\n"
+              << "  " << result.wallMs << " ms, " << perSec << " missions/s\n";
+    printProbes("Probes: ", "\n");
+    return 0;
+}
 
-    if (inet_pton(AF_INET, "127.0.0.1", &servAddr.sin_addr) <= 0) {
-        std::cerr << "inet_pton failed.\n";
-        closesocket(sock);
-        WSACleanup();
-        return 1;
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt) || opt.help) {
+        printUsage(argv[0]);
+        return opt.help ? 0 : 1;
     }
-    if (connect(sock, (sockaddr*)&servAddr, sizeof(servAddr)) == SOCKET_ERROR) {
-        std::cerr << "connect() failed.\n";
-        closesocket(sock);
-        WSACleanup();
+
+    // Every run has a seed, so any run can be replayed with --seed
+    if (!opt.seeded) {
+        std::random_device device;
+        opt.seed = ((uint64_t)device() << 32) | device();
+    }
+    if (opt.batch > 0) {
+        return runBatchMode(opt);
+    }
+
+    // A map file is only mapped here; the tiles under the grid are read
+    // when the fires are loaded
+    MapFile mapFile;
+    if (!opt.mapFile.empty()) {
+        std::string error;
+        if (!mapFile.open(opt.mapFile, error)) {
+            std::cerr << "[Drone] " << error << "\n";
+            return 1;
+        }
+        if (opt.rows == 0) {
+            if (mapFile.getRows() > MAX_MAP_GRID || mapFile.getCols() > MAX_MAP_GRID) {
+                std::cerr << "[Drone] " << opt.mapFile << " is " << mapFile.getRows() << " x "
+                          << mapFile.getCols() << "; pick a window of it with --grid\n";
+                return 1;
+            }
+            opt.rows = mapFile.getRows();
+            opt.cols = mapFile.getCols();
+        }
+    }
+
+    // Initialize sockets
+    if (!netInit()) {
+        std::cerr << "Socket startup failed.\n";
         return 1;
     }
-    std::cout << "[Drone] Connected to server!\n\n";
+
+    // Messages to the base station; offline runs only count what they would
+    // send. They go through a sender thread so the flight loop never waits
+    // on the network; 'outbox' holds what the queue had no room for, and
+    // new reports are held back (and coalesce) until it has gone out.
+    NetSocket sock = NET_INVALID;
+    std::unique_ptr<SendQueue> queue;
+    std::string outbox;
+    uint64_t messagesSent = 0, bytesSent = 0;
+    MissionLog missionLog;
+    auto drainOutbox = [&]() {
+        if (queue && !outbox.empty()) {
+            outbox.erase(0, queue->push(outbox.data(), outbox.size()));
+        }
+        return outbox.empty();
+    };
+    auto report = [&](const std::string& line) {
+        messagesSent++;
+        bytesSent += line.size();
+        missionLog.message(opt.droneId, line.data(), line.size());
+        if (opt.offline) return;
+        if (queue) {
+            outbox += line;
+            drainOutbox();
+        } else {
+            sendLine(sock, line);
+        }
+    };
+
+    // Telemetry version in use, 0 = text lines. Offline runs count what the
+    // requested protocol would send.
+    int telemetry = opt.binary ? TELEMETRY_VERSION : 0;
+    if (!opt.offline) {
+        sock = connectToServer();
+        if (sock == NET_INVALID) {
+            netCleanup();
+            return 1;
+        }
+        std::cout << "[Drone] Connected to server!\n\n";
+    }
 
     // Prompt #1: grid size in one line
-    int rows, cols;
-    std::cout << "Enter the grid size (rows columns): ";
-    std::cin >> rows >> cols;
+    int rows = opt.rows, cols = opt.cols;
+    if (rows == 0) {
+        std::cout << "Enter the grid size (rows columns): ";
+        std::cin >> rows >> cols;
+        if (!gridFits(rows, cols)) {
+            std::cerr << "[Drone] Error: the grid needs 1 to " << std::numeric_limits<int>::max()
+                      << " cells.\n";
+            if (sock != NET_INVALID) netClose(sock);
+            netCleanup();
+            return 1;
+        }
+    }
+
+    // Tell the station who we are and how big the grid is
+    if (!opt.offline) {
+        telemetry = negotiateTelemetry(sock, opt.droneId, rows, cols, opt.binary);
+        std::cout << "[Drone] Reporting with " << (telemetry ? "binary telemetry" : "text messages") << "\n";
+        if (opt.sendQueue > 0) {
+            queue = std::make_unique<SendQueue>(sock, opt.sendQueue);
+        }
+    }
 
     // Create the drone’s local map
     GridMap map(rows, cols);
-    // Populate with random fires (10% chance)
-    map.populateRandomFires(10);
+    map.setSeed(opt.seed);
+    // Populate with random fires (10% chance unless --fires says otherwise)
+    if (mapFile.isOpen()) {
+        map.loadFires(mapFile, opt.mapTop, opt.mapLeft);
+    } else {
+        map.populateRandomFires(opt.firePercent);
+    }
 
     // Prompt #2: drone start coordinate in one line
-    int droneRow, droneCol;
-    std::cout << "Enter the drone's starting coordinate (row column): ";
-    std::cin >> droneRow >> droneCol;
+    int droneRow = opt.startRow, droneCol = opt.startCol;
+    if (droneRow < 0) {
+        std::cout << "Enter the drone's starting coordinate (row column): ";
+        std::cin >> droneRow >> droneCol;
+    }
+
+    if (!opt.saveScenario.empty() && !writeScenario(opt.saveScenario, opt, rows, cols, droneRow, droneCol)) {
+        std::cerr << "[Drone] cannot write scenario " << opt.saveScenario << "\n";
+    }
+    if (!opt.headless) {
+        std::cout << "[Drone] Seed " << opt.seed << " (replay with --seed " << opt.seed << ")\n";
+    }
+
+    // Fire cells the drone "sees" for the first time are collected and go to
+    // the server in one message every --report-every moves: "FIRE r c" for a
+    // single cell, "FIREBATCH n r1 c1 r2 c2 ..." for several. With binary
+    // telemetry the cells that changed go out as window frames instead.
+    uint64_t firesFound = 0;
+    std::vector<std::pair<int,int>> pendingFires;
+    int movesSinceReport = 0;
+    std::string batch;
+    TelemetryTracker tracker(rows, cols);
+    auto reportFires = [&]() {
+        // Station falling behind: keep collecting, send it all together later
+        if (!drainOutbox()) return;
+        movesSinceReport = 0;
+        firesFound += pendingFires.size();
+        if (telemetry) {
+            pendingFires.clear();
+            tracker.flush(batch);
+            if (!batch.empty()) report(batch);
+            batch.clear();
+            return;
+        }
+        if (pendingFires.empty()) return;
+        batch.clear();
+        if (pendingFires.size() == 1) {
+            batch += "FIRE";
+        } else {
+            batch += "FIREBATCH ";
+            appendInt(batch, (int)pendingFires.size());
+        }
+        for (auto [r, c] : pendingFires) {
+            batch += ' ';
+            appendInt(batch, r);
+            batch += ' ';
+            appendInt(batch, c);
+        }
+        batch += '\n';
+        report(batch);
+        pendingFires.clear();
+    };
+
+    auto waitOutbox = [&]() {
+        while (!drainOutbox()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    // Ends the run early: send what is left, tell the server, release the socket
+    SendQueue::Stats sendStats;
+    auto closeConnection = [&]() {
+        waitOutbox();
+        reportFires();
+        if (!opt.offline) {
+            if (telemetry) {
+                batch.clear();
+                tracker.end(batch);
+                report(batch);
+            } else {
+                report("END\n");
+            }
+            if (queue) {
+                waitOutbox();
+                queue->close();
+                sendStats = queue->getStats();
+            }
+            netCloseGracefully(sock, 1000);
+        }
+        netCleanup();
+        if (missionLog.isOpen()) {
+            missionLog.close();
+            const MissionLog::Stats& ls = missionLog.getStats();
+            std::cerr << "[Drone] Logged " << ls.events << " events (" << ls.bytes << " bytes) to "
+                      << opt.logFile << (ls.failed ? "; writing failed\n" : "\n");
+        }
+    };
 
     // Check if coordinates are valid
     if (droneRow < 0 || droneRow >= rows || droneCol < 0 || droneCol >= cols) {
         std::cerr << "[Drone] Error: starting position is out of bounds.\n";
-        sendLine(sock, "END");
-        closesocket(sock);
-        WSACleanup();
+        closeConnection();
         return 1;
     }
 
@@ -248,134 +690,289 @@ int main() {
     if (map.getCell(droneRow, droneCol) == 'X') {
         std::cerr << "[Drone] Cannot start at (" << droneRow << "," << droneCol 
                   << ") - it's on fire.\n";
-        sendLine(sock, "END");
-        closesocket(sock);
-        WSACleanup();
+        closeConnection();
         return 1;
     }
 
-    // BFS "discovered" data
-    std::vector<std::vector<bool>> discovered(rows, std::vector<bool>(cols, false));
-
-    // Mark neighbors, send FIRE messages for newly seen fires, etc.
-    discoverCells(map, discovered, droneRow, droneCol, sock);
-
-    int stepCount = 0;
-    double spreadChance = 0.02; // fire spread chance
-    bool signalLost = false;
-    time_t start = time(0);
-
-    // Scan the entire map row by row
-    for (int i = 0; i < rows && !signalLost; i++) {
-        if (i % 2 == 0) {
-            // left->right
-            for (int j = 0; j < cols && !signalLost; j++) {
-                if (discovered[i][j]) continue;
-
-                auto path = getPathBFS(map, droneRow, droneCol, i, j);
-                if (path.empty()) {
-                    // If no path, check if there is any undiscovered cell we can still reach
-                    if (!anyReachableUndiscovered(map, discovered, droneRow, droneCol)) {
-                        std::cout << "Signal lost!\n";
-                        signalLost = true;
-                    }
-                    continue;
-                }
-                for (size_t idx = 1; idx < path.size() && !signalLost; idx++) {
-                    auto [r, c] = path[idx];
-
-                    // If the next cell is on fire, try a path recalculation
-                    if (map.getCell(r,c) == 'X') {
-                        auto newPath = getPathBFS(map, droneRow, droneCol, i, j);
-                        if (newPath.empty()) {
-                            if (!anyReachableUndiscovered(map, discovered, droneRow, droneCol)) {
-                                std::cout << "Signal lost!\n";
-                                signalLost = true;
-                            }
-                            break;
-                        } else {
-                            path = newPath;
-                            idx = 0;
-                            continue;
-                        }
-                    }
-
-                    // Move drone
-                    droneRow = r; 
-                    droneCol = c;
-                    discoverCells(map, discovered, droneRow, droneCol, sock);
-
-                    stepCount++;
-                    if (stepCount % 5 == 0) {
-                        map.spreadFires(spreadChance);
-                    }
-
-                    clearScreen();
-                    std::cout << "=== Drone Map ===\n";
-                    displayDroneMap(map, discovered, droneRow, droneCol);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
-                }
+    if (!opt.logFile.empty()) {
+        std::string error;
+        if (!missionLog.open(opt.logFile, rows, cols, opt.seed, error)) {
+            std::cerr << "[Drone] " << error << "\n";
+            closeConnection();
+            return 1;
+        }
+        missionLog.fires(map);
+    }
+
+    // A fleet: drone 1 takes off from the start, the others from points
+    // spread along the start row, and they cover the map together
+    if (opt.drones > 1) {
+        std::vector<std::pair<int,int>> starts{{droneRow, droneCol}};
+        for (int k = 1; k < opt.drones; k++) {
+            int c = (int)((long long)k * cols / opt.drones);
+            for (int tries = 0; tries < cols && map.isFire(droneRow, c); tries++) c = (c + 1) % cols;
+            starts.emplace_back(droneRow, c);
+        }
+        FleetConfig fleetConfig;
+        fleetConfig.spreadChance = opt.spreadChance;
+        fleetConfig.spreadEvery = opt.spreadEvery;
+        fleetConfig.perceptionRange = opt.range;
+        ThreadPool pool(opt.threads);
+        Fleet fleet(map, fleetConfig, pool);
+
+        fleet.onFiresSeen = [&](const std::vector<std::pair<int,int>>& fires) {
+            pendingFires.insert(pendingFires.end(), fires.begin(), fires.end());
+        };
+        // The log keeps the order of a tick: every drone moves and looks at
+        // the square around it, then the fire spreads
+        std::vector<int> tickIgnited;
+        fleet.onSpread = [&](const std::vector<int>& ignited) {
+            if (missionLog.isOpen()) tickIgnited = ignited;
+        };
+        auto logDrone = [&](int k, int row, int col) {
+            int range = fleetConfig.perceptionRange;
+            missionLog.move(k + 1, row, col);
+            missionLog.scan(k + 1, std::max(row - range, 0), std::max(col - range, 0),
+                            std::min(row + range, rows - 1), std::min(col + range, cols - 1));
+        };
+        auto logTick = [&]() {
+            if (!missionLog.isOpen()) return;
+            for (size_t k = 0; k < fleet.getDrones().size(); k++) {
+                logDrone((int)k, fleet.getDrones()[k].row, fleet.getDrones()[k].col);
             }
-        } else {
-            // right->left
-            for (int j = cols - 1; j >= 0 && !signalLost; j--) {
-                if (discovered[i][j]) continue;
-
-                auto path = getPathBFS(map, droneRow, droneCol, i, j);
-                if (path.empty()) {
-                    if (!anyReachableUndiscovered(map, discovered, droneRow, droneCol)) {
-                        std::cout << "Signal lost!\n";
-                        signalLost = true;
-                    }
-                    continue;
+            missionLog.spread(tickIgnited);
+            tickIgnited.clear();
+        };
+        MapRenderer renderer(rows, cols, opt.fps, "DX?");
+        std::vector<char> occupied((size_t)rows * cols, 0);
+        auto fleetGlyph = [&](int r, int c) {
+            if (!fleet.getDiscovered().isDiscovered(r, c)) return '?';
+            if (occupied[(size_t)r * cols + c]) return 'D';
+            return map.isFire(r, c) ? 'X' : ' ';
+        };
+        auto placeDrones = [&](char value) {
+            for (const Fleet::Drone& drone : fleet.getDrones()) {
+                occupied[(size_t)drone.row * cols + drone.col] = value;
+            }
+        };
+        fleet.onTick = [&]() {
+            logTick();
+            if (++movesSinceReport >= opt.reportEvery) {
+                reportFires();
+            }
+            uint64_t tick = fleet.getStats().ticks;
+            if (opt.renderEvery == 0 || tick % opt.renderEvery != 0) return;
+            placeDrones(1);
+            if (opt.headless) {
+                std::cout << "=== Fleet Map (tick " << tick << ") ===\n";
+                for (int r = 0; r < rows; r++) {
+                    for (int c = 0; c < cols; c++) std::cout << fleetGlyph(r, c);
+                    std::cout << '\n';
                 }
-                for (size_t idx = 1; idx < path.size() && !signalLost; idx++) {
-                    auto [r, c] = path[idx];
-
-                    // If the next cell is on fire, try a path recalculation
-                    if (map.getCell(r,c) == 'X') {
-                        auto newPath = getPathBFS(map, droneRow, droneCol, i, j);
-                        if (newPath.empty()) {
-                            if (!anyReachableUndiscovered(map, discovered, droneRow, droneCol)) {
-                                std::cout << "Signal lost!\n";
-                                signalLost = true;
-                            }
-                            break;
-                        } else {
-                            path = newPath;
-                            idx = 0;
-                            continue;
-                        }
-                    }
-
-                    // Move drone
-                    droneRow = r; 
-                    droneCol = c;
-                    discoverCells(map, discovered, droneRow, droneCol, sock);
-
-                    stepCount++;
-                    if (stepCount % 5 == 0) {
-                        map.spreadFires(spreadChance);
-                    }
-
-                    clearScreen();
-                    std::cout << "=== Drone Map ===\n";
-                    displayDroneMap(map, discovered, droneRow, droneCol);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            } else {
+                renderer.draw("=== Fleet Map ===", fleetGlyph);
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            }
+            placeDrones(0);
+        };
+
+        auto wallStart = std::chrono::steady_clock::now();
+        if (missionLog.isOpen()) {
+            for (size_t k = 0; k < starts.size(); k++) logDrone((int)k, starts[k].first, starts[k].second);
+        }
+        bool signalLost = !fleet.run(starts);
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+        const Fleet::Stats& fs = fleet.getStats();
+        closeConnection();
+
+        if (opt.headless) {
+            std::cout << "{\"rows\":" << rows << ",\"cols\":" << cols
+                      << ",\"drones\":" << opt.drones
+                      << ",\"threads\":" << pool.size()
+                      << ",\"seed\":" << opt.seed
+                      << ",\"ticks\":" << fs.ticks
+                      << ",\"coverageTicks\":" << fs.coverageTicks
+                      << ",\"steps\":" << fs.moves
+                      << ",\"firesFound\":" << firesFound
+                      << ",\"planningCalls\":" << fs.decisions
+                      << ",\"planningMs\":" << fs.planNanos / 1e6
+                      << ",\"planningWallMs\":" << fs.planWallNanos / 1e6
+                      << ",\"rebalances\":" << fs.rebalances
+                      << ",\"spreadSteps\":" << fs.spreads
+                      << ",\"spreadMs\":" << fs.spreadNanos / 1e6
+                      << ",\"messagesSent\":" << messagesSent
+                      << ",\"bytesSent\":" << bytesSent
+                      << ",\"undiscovered\":" << fleet.getUndiscovered()
+                      << ",\"signalLost\":" << (signalLost ? "true" : "false")
+                      << ",\"wallMs\":" << wallMs;
+            printProbes(",\"probes\":");
+            std::cout << "}\n";
+            return signalLost ? 2 : 0;
+        }
+
+        if (signalLost) {
+            std::cout << "Signal lost!\n";
+        } else if (opt.renderEvery > 0) {
+            renderer.draw("=== Final Fleet Map ===", fleetGlyph, true);
+        }
+        std::cout << "Drones: " << opt.drones << ", ticks: " << fs.ticks
+                  << ", moves: " << fs.moves << ", frontier searches: " << fs.decisions
+                  << ", planning time " << fs.planNanos / 1e6 << " ms"
+                  << " (" << fs.planWallNanos / 1e6 << " ms on " << pool.size() << " threads)"
+                  << ", rebalances: " << fs.rebalances << "\n";
+        for (size_t k = 0; k < fleet.getDrones().size(); k++) {
+            const Fleet::Drone& drone = fleet.getDrones()[k];
+            std::cout << "  drone " << k + 1 << ": " << drone.moves << " moves, "
+                      << drone.found << " cells found first\n";
+        }
+        printProbes("Probes: ", "\n");
+        std::cout << (signalLost ? "\nSimulation ended prematurely (Signal lost!).\n" : "\nDone scanning!\n");
+#ifdef _WIN32
+        system("pause");
+#endif
+        return 0;
+    }
+
+    // Exploration: frontier search by default; ExploreMode::Sweep flies the
+    // original row-by-row sweep
+    MissionConfig config;
+    config.mode = opt.mode;
+    config.planner = opt.planner;
+    config.spreadChance = opt.spreadChance; // fire spread chance
+    config.spreadEvery = opt.spreadEvery;
+    config.sensor = opt.sensor;
+    config.perceptionRange = opt.range;
+    Mission mission(map, config);
+
+    mission.onFiresSeen = [&](const std::vector<std::pair<int,int>>& fires) {
+        pendingFires.insert(pendingFires.end(), fires.begin(), fires.end());
+    };
+    mission.onSpread = [&](const std::vector<int>& ignited) { missionLog.spread(ignited); };
+    // A Scan record stands for the whole square, so other footprints log
+    // the cells they saw as Cells records: those discovered and not yet
+    // logged, with the fires among them
+    DiscoveredLayer logged;
+    std::vector<uint64_t> loggedCells;
+    if (missionLog.isOpen() && opt.sensor != SensorShape::Square) logged.reset(rows, cols);
+    auto logSeen = [&](int top, int left, int bottom, int right) {
+        const DiscoveredLayer& discovered = mission.getDiscovered();
+        loggedCells.clear();
+        int w0 = left >> 6, w1 = right >> 6;
+        for (int r = top; r <= bottom; r++) {
+            const uint64_t* fire = map.fireRow(r);
+            for (int w = w0; w <= w1; w++) {
+                uint64_t mask = bitRange(w == w0 ? left & 63 : 0, w == w1 ? right & 63 : 63);
+                for (uint64_t bits = logged.mark(r, w, discovered.row(r)[w] & mask); bits; bits &= bits - 1) {
+                    int bit = __builtin_ctzll(bits);
+                    loggedCells.push_back(((uint64_t)r * cols + w * 64 + bit) * 2 + ((fire[w] >> bit) & 1));
                 }
             }
         }
+        if (!loggedCells.empty()) missionLog.cells(opt.droneId, loggedCells);
+    };
+    auto missionStart = std::chrono::steady_clock::now();
+    mission.onScan = [&](int top, int left, int bottom, int right) {
+        missionLog.move(opt.droneId, mission.getDroneRow(), mission.getDroneCol());
+        if (opt.sensor == SensorShape::Square) {
+            missionLog.scan(opt.droneId, top, left, bottom, right);
+        } else if (missionLog.isOpen()) {
+            logSeen(top, left, bottom, right);
+        }
+        if (!telemetry) return;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - missionStart).count();
+        tracker.scan(map, mission.getDiscovered(), top, left, bottom, right, (uint64_t)ms, batch);
+    };
+    // Interactive display: only the cells that changed are redrawn
+    MapRenderer renderer(rows, cols, opt.fps, "DX?");
+    auto droneGlyph = [&](int droneR, int droneC) {
+        return [&map, &mission, droneR, droneC](int r, int c) {
+            if (!mission.getDiscovered().isDiscovered(r, c)) return '?';
+            if (r == droneR && c == droneC) return 'D';
+            return map.isFire(r, c) ? 'X' : ' ';
+        };
+    };
+    // Longest gap between two moves: what a stalled station would stretch
+    auto lastMove = std::chrono::steady_clock::now();
+    double maxStepMs = 0;
+    mission.onMove = [&]() {
+        if (++movesSinceReport >= opt.reportEvery) {
+            reportFires();
+        }
+        auto now = std::chrono::steady_clock::now();
+        maxStepMs = std::max(maxStepMs, std::chrono::duration<double, std::milli>(now - lastMove).count());
+        lastMove = now;
+        uint64_t step = mission.getStats().steps;
+        if (opt.renderEvery == 0 || step % opt.renderEvery != 0) return;
+        if (opt.headless) {
+            std::cout << "=== Drone Map (move " << step << ") ===\n";
+            displayDroneMap(map, mission.getDiscovered(), mission.getDroneRow(), mission.getDroneCol());
+            return;
+        }
+        renderer.draw("=== Drone Map ===", droneGlyph(mission.getDroneRow(), mission.getDroneCol()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    lastMove = wallStart;
+    bool signalLost = !mission.run(droneRow, droneCol);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    const Mission::Stats& ms = mission.getStats();
+
+    if (opt.headless) {
+        closeConnection();
+        // One JSON object on stdout, for scripts
+        std::cout << "{\"rows\":" << rows << ",\"cols\":" << cols
+                  << ",\"mode\":\"" << modeName(opt.mode) << "\""
+                  << ",\"sensor\":\"" << sensorShapeName(opt.sensor) << "\",\"range\":" << opt.range
+                  << ",\"seed\":" << opt.seed
+                  << ",\"steps\":" << ms.steps
+                  << ",\"firesFound\":" << firesFound
+                  << ",\"planningCalls\":" << ms.decisions
+                  << ",\"planningMs\":" << ms.planNanos / 1e6
+                  << ",\"spreadSteps\":" << ms.spreads
+                  << ",\"spreadMs\":" << ms.spreadNanos / 1e6
+                  << ",\"messagesSent\":" << messagesSent
+                  << ",\"bytesSent\":" << bytesSent
+                  << ",\"sendQueueMaxBytes\":" << sendStats.maxDepth
+                  << ",\"sendLatencyAvgMs\":" << (sendStats.messages ? sendStats.latencyNanos / 1e6 / sendStats.messages : 0.0)
+                  << ",\"sendLatencyMaxMs\":" << sendStats.maxLatencyNanos / 1e6
+                  << ",\"maxStepMs\":" << maxStepMs
+                  << ",\"undiscovered\":" << mission.getUndiscovered()
+                  << ",\"signalLost\":" << (signalLost ? "true" : "false")
+                  << ",\"wallMs\":" << wallMs;
+        printProbes(",\"probes\":");
+        std::cout << "}\n";
+        return signalLost ? 2 : 0;
     }
 
     // Display final map if the drone didn't lose signal
-    if (!signalLost) {
-        clearScreen();
-        std::cout << "=== Final Drone Map ===\n";
-        displayDroneMap(map, discovered, -1, -1);
+    if (signalLost) {
+        std::cout << "Signal lost!\n";
+    } else if (opt.renderEvery > 0) {
+        renderer.draw("=== Final Drone Map ===", droneGlyph(-1, -1), true);
     }
 
-    double seconds = difftime(time(0), start);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
     std::cout << "Seconds since start: " << seconds << "s\n";
+    std::cout << "Moves: " << ms.steps << ", planning calls: " << ms.decisions
+              << ", planning time " << ms.planNanos / 1e6 << " ms"
+              << ", spread time " << ms.spreadNanos / 1e6 << " ms\n";
+    const PathWorkspace::Stats& ps = mission.getPlanner().getStats();
+    std::cout << "Path queries (" << mission.getPlanner().name() << "): " << ps.queries
+              << ", avg " << (ps.queries ? ps.totalNanos / ps.queries / 1000.0 : 0.0) << " us"
+              << ", max " << ps.maxNanos / 1000.0 << " us"
+              << ", expanded " << ps.expanded
+              << ", buffer allocations: " << ps.allocations << "\n";
+    const PathWorkspace::Stats& fs = mission.getFrontierWorkspace().getStats();
+    std::cout << "Frontier searches: " << fs.queries
+              << ", avg " << (fs.queries ? fs.totalNanos / fs.queries / 1000.0 : 0.0) << " us"
+              << ", expanded " << fs.expanded << "\n";
+    const DStarLite::Stats& rs = mission.getRepair().getStats();
+    std::cout << "Incremental replans: " << rs.resets << " legs, " << rs.repairs << " repairs"
+              << ", expanded " << rs.expanded
+              << ", fire cells fed " << rs.changedCells << "\n";
+    printProbes("Probes: ", "\n");
     if (signalLost) {
         std::cout << "\nSimulation ended prematurely (Signal lost!).\n";
     } else {
@@ -383,11 +980,10 @@ int main() {
     }
 
     // tell the server we’re done
-    sendLine(sock, "END");
-
-    closesocket(sock);
-    WSACleanup();
+    closeConnection();
+#ifdef _WIN32
     system("pause");
+#endif
     
     return 0;
 }
@@ -0,0 +1,247 @@
+#include "Fleet.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+Fleet::Fleet(GridMap& map, const FleetConfig& config, ThreadPool& pool)
+    : map(map), config(config), pool(pool) {}
+
+// A drone keeps its route while the next move is clear and its target still
+// has something undiscovered around it; other drones may have seen it first
+bool Fleet::needsPlan(int k) const
+{
+    const Pilot& pilot = pilots[k];
+    if (drones[k].done) return false;
+    if (pilot.replan || pilot.next >= pilot.path.size()) return true;
+    auto [r, c] = pilot.path[pilot.next];
+    if (map.isFire(r, c)) return true;
+    auto [tr, tc] = pilot.path.back();
+    int range = config.perceptionRange;
+    return !discovered.anyUndiscovered(tr - range, tc - range, tr + range, tc + range);
+}
+
+// Nearest frontier cell of the drone's strip. A drone whose strip has
+// nothing left that it can reach flies to the nearest frontier anywhere and
+// gives the strip up until the next rebalance.
+void Fleet::plan(int k, PathWorkspace& ws)
+{
+    auto start = std::chrono::steady_clock::now();
+    Drone& drone = drones[k];
+    Pilot& pilot = pilots[k];
+    int range = config.perceptionRange;
+    int cols = map.getCols();
+    pilot.replan = false;
+    pilot.next = 1;
+    bool found = false;
+    if (drone.stripBegin < drone.stripEnd) {
+        // Inside its strip a drone first looks only along the strip: a
+        // narrow corridor costs a fraction of a search over the whole map
+        if (drone.col >= drone.stripBegin - range && drone.col < drone.stripEnd + range) {
+            found = findFrontierPath(map, discovered, ws, drone.row, drone.col, range,
+                                     drone.stripBegin, drone.stripEnd, true, pilot.path);
+            pilot.decisions++;
+        }
+        if (!found) {
+            found = findFrontierPath(map, discovered, ws, drone.row, drone.col, range,
+                                     drone.stripBegin, drone.stripEnd, false, pilot.path);
+            pilot.decisions++;
+            int targetCol = found ? pilot.path.back().second : -1;
+            if (targetCol < drone.stripBegin || targetCol >= drone.stripEnd) {
+                drone.stripBegin = drone.stripEnd = 0;
+                pilot.wantsRebalance = true;
+            }
+        }
+    } else {
+        found = findFrontierPath(map, discovered, ws, drone.row, drone.col, range,
+                                 0, cols, false, pilot.path);
+        pilot.decisions++;
+    }
+    if (!found) drone.done = true;
+    pilot.planNanos += nanosSince(start);
+}
+
+void Fleet::move(int k)
+{
+    Drone& drone = drones[k];
+    Pilot& pilot = pilots[k];
+    if (drone.done || pilot.next >= pilot.path.size()) return;
+    auto [r, c] = pilot.path[pilot.next++];
+    drone.row = r;
+    drone.col = c;
+    drone.moves++;
+    look(k);
+}
+
+// Notes the undiscovered cells of the drone's perception window. Runs
+// alongside the other drones, so it only reads the discovered layer.
+void Fleet::look(int k)
+{
+    Drone& drone = drones[k];
+    Pilot& pilot = pilots[k];
+    int range = config.perceptionRange;
+    int r0 = std::max(drone.row - range, 0), r1 = std::min(drone.row + range, map.getRows() - 1);
+    int c0 = std::max(drone.col - range, 0), c1 = std::min(drone.col + range, map.getCols() - 1);
+    pilot.seen.clear();
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            if (!discovered.isDiscovered(r, c)) pilot.seen.emplace_back(r, c);
+        }
+    }
+}
+
+// Marks what look() noted; returns how many cells the drone saw first.
+// Called for one drone after another, in drone order.
+int Fleet::discover(int k)
+{
+    Pilot& pilot = pilots[k];
+    int found = 0;
+    for (auto [r, c] : pilot.seen) {
+        if (!discovered.mark(r, c)) continue;
+        found++;
+        if (map.isFire(r, c)) pilot.newFires.emplace_back(r, c);
+    }
+    pilot.seen.clear();
+    drones[k].found += found;
+    return found;
+}
+
+// Re-cuts the strips so that every drone still flying gets an equal share
+// of the undiscovered cells; drones take the strips in column order
+void Fleet::rebalance()
+{
+    std::vector<int> active;
+    for (int k = 0; k < (int)drones.size(); k++) {
+        if (drones[k].done) {
+            drones[k].stripBegin = drones[k].stripEnd = 0;
+        } else {
+            active.push_back(k);
+        }
+    }
+    std::stable_sort(active.begin(), active.end(),
+                     [&](int a, int b) { return drones[a].col < drones[b].col; });
+
+    discovered.columnCounts(counts);
+    long long total = 0;
+    for (int count : counts) total += count;
+    int cols = map.getCols();
+    int col = 0;
+    long long sum = 0;
+    int n = (int)active.size();
+    for (int i = 0; i < n; i++) {
+        int begin = col;
+        if (i == n - 1) {
+            col = cols;
+        } else {
+            long long goal = total * (i + 1) / n;
+            while (col < cols && sum < goal) sum += counts[col++];
+        }
+        Drone& drone = drones[active[i]];
+        if (drone.stripBegin != begin || drone.stripEnd != col) pilots[active[i]].replan = true;
+        drone.stripBegin = begin;
+        drone.stripEnd = col;
+    }
+    for (Pilot& pilot : pilots) pilot.wantsRebalance = false;
+    lastRebalance = stats.ticks;
+    stats.rebalances++;
+}
+
+bool Fleet::run(const std::vector<std::pair<int,int>>& starts)
+{
+    int k = (int)starts.size();
+    discovered.reset(map.getRows(), map.getCols());
+    drones.assign(k, Drone());
+    pilots.assign(k, Pilot());
+    stats = Stats();
+
+    auto reportFires = [&]() {
+        tickFires.clear();
+        for (Pilot& pilot : pilots) {
+            tickFires.insert(tickFires.end(), pilot.newFires.begin(), pilot.newFires.end());
+            pilot.newFires.clear();
+        }
+        if (!tickFires.empty() && onFiresSeen) onFiresSeen(tickFires);
+    };
+
+    for (int i = 0; i < k; i++) {
+        drones[i].row = starts[i].first;
+        drones[i].col = starts[i].second;
+        look(i);
+        discover(i);
+    }
+    reportFires();
+    rebalance();
+
+    auto planTask = [&](int i) {
+        std::unique_ptr<PathWorkspace> ws;
+        {
+            std::lock_guard<std::mutex> guard(workspaceLock);
+            if (!workspaces.empty()) {
+                ws = std::move(workspaces.back());
+                workspaces.pop_back();
+            }
+        }
+        if (!ws) ws = std::make_unique<PathWorkspace>();
+        plan(planning[i], *ws);
+        std::lock_guard<std::mutex> guard(workspaceLock);
+        workspaces.push_back(std::move(ws));
+    };
+    auto moveTask = [&](int i) { move(i); };
+
+    while (true) {
+        // Plan on the state the last tick left behind
+        planning.clear();
+        for (int i = 0; i < k; i++) {
+            if (needsPlan(i)) planning.push_back(i);
+        }
+        if (!planning.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            pool.parallelFor((int)planning.size(), planTask);
+            stats.planWallNanos += nanosSince(start);
+        }
+        bool flying = false;
+        for (int i = 0; i < k && !flying; i++) {
+            flying = !drones[i].done && pilots[i].next < pilots[i].path.size();
+        }
+        if (!flying) break;
+
+        // Then everyone moves at once
+        int before = discovered.getUndiscovered();
+        pool.parallelFor(k, moveTask);
+        for (int i = 0; i < k; i++) discover(i);
+        stats.ticks++;
+        if (discovered.getUndiscovered() < before) stats.coverageTicks = stats.ticks;
+        reportFires();
+
+        if (config.spreadEvery > 0 && config.spreadChance > 0 && stats.ticks % config.spreadEvery == 0) {
+            auto start = std::chrono::steady_clock::now();
+            map.spreadFires(config.spreadChance, pool);
+            stats.spreads++;
+            stats.spreadNanos += nanosSince(start);
+            if (onSpread) onSpread(map.getLastIgnited());
+        }
+
+        bool wanted = false;
+        for (const Pilot& pilot : pilots) wanted = wanted || pilot.wantsRebalance;
+        if (wanted && stats.ticks - lastRebalance >= (uint64_t)config.rebalanceEvery) {
+            rebalance();
+        }
+        if (onTick) onTick();
+    }
+
+    for (int i = 0; i < k; i++) {
+        stats.moves += drones[i].moves;
+        stats.decisions += pilots[i].decisions;
+        stats.planNanos += pilots[i].planNanos;
+    }
+    return discovered.getUndiscovered() == 0;
+}
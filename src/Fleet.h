@@ -0,0 +1,113 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "GridMap.h"
+#include "Coverage.h"
+#include "Pathfinding.h"
+#include "ThreadPool.h"
+
+struct FleetConfig {
+    int perceptionRange = 2;
+    double spreadChance = 0.02;
+    int spreadEvery = 5;        // ticks between spreadFires calls, 0 = never
+    int rebalanceEvery = 32;    // fewest ticks between two strip rebalances
+};
+
+// K drones exploring one map together, one move each per tick.
+//  - The map is cut into vertical strips, one per drone, each holding an
+//    equal share of the undiscovered cells. A drone flies frontier search
+//    towards the nearest cell of its own strip; once its strip is done or
+//    fire cuts it off, it helps wherever is nearest and the strips are
+//    rebalanced over what is left.
+//  - All drones share one discovered layer. Planning and moving run on the
+//    pool, one task per drone, in two phases that only read the state of
+//    the tick before: a moving drone notes the undiscovered cells around
+//    it, and the notes are marked afterwards in drone order. So the flight,
+//    down to which drone saw a cell first, does not depend on the number
+//    of threads.
+//  - Every spreadEvery ticks one spreadFires step burns for everyone.
+class Fleet {
+public:
+    struct Stats {
+        uint64_t ticks = 0;         // time steps flown
+        uint64_t coverageTicks = 0; // tick of the last new discovery
+        uint64_t moves = 0;         // summed over the drones
+        uint64_t decisions = 0;     // frontier searches
+        uint64_t planNanos = 0;     // time in them, summed over the drones
+        uint64_t planWallNanos = 0; // wall time of the planning phases
+        uint64_t spreads = 0;
+        uint64_t spreadNanos = 0;
+        uint64_t rebalances = 0;
+    };
+
+    struct Drone {
+        int row = 0, col = 0;
+        int stripBegin = 0, stripEnd = 0;   // its columns [begin, end)
+        uint64_t moves = 0;
+        uint64_t found = 0;                 // cells it discovered first
+        bool done = false;                  // nothing reachable is left for it
+    };
+
+    Fleet(GridMap& map, const FleetConfig& config, ThreadPool& pool);
+
+    // Called once per tick with the fire cells the fleet saw for the first
+    // time, in drone order (never with an empty list)
+    std::function<void(const std::vector<std::pair<int,int>>& fires)> onFiresSeen;
+    // Called after every tick
+    std::function<void()> onTick;
+    // Called after each spread step with the cells it ignited
+    std::function<void(const std::vector<int>& ignited)> onSpread;
+
+    // Flies one drone from each start until no drone can reach anything
+    // undiscovered. Returns false if undiscovered cells remain ("signal lost").
+    bool run(const std::vector<std::pair<int,int>>& starts);
+
+    const CoverageLayer& getDiscovered() const { return discovered; }
+    int getUndiscovered() const { return discovered.getUndiscovered(); }
+    const std::vector<Drone>& getDrones() const { return drones; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    // What a drone keeps between ticks for its own planning
+    struct Pilot {
+        std::vector<std::pair<int,int>> path;
+        size_t next = 0;            // index of the next move in 'path'
+        bool replan = true;
+        bool wantsRebalance = false;
+        uint64_t decisions = 0;
+        uint64_t planNanos = 0;
+        std::vector<std::pair<int,int>> newFires;
+        std::vector<std::pair<int,int>> seen;  // undiscovered cells around it after its move
+    };
+
+    bool needsPlan(int k) const;
+    void plan(int k, PathWorkspace& ws);
+    void move(int k);
+    void look(int k);
+    int discover(int k);
+    void rebalance();
+
+    GridMap& map;
+    FleetConfig config;
+    ThreadPool& pool;
+    CoverageLayer discovered;
+    std::vector<Drone> drones;
+    std::vector<Pilot> pilots;
+    std::vector<int> planning;      // drones planning this tick
+    // Search buffers are map-sized, so there is one per concurrent search
+    // rather than one per drone
+    std::mutex workspaceLock;
+    std::vector<std::unique_ptr<PathWorkspace>> workspaces;
+    std::vector<int> counts;        // rebalance scratch
+    std::vector<std::pair<int,int>> tickFires;
+    uint64_t lastRebalance = 0;
+    Stats stats;
+};
+
+#endif // FLEET_H
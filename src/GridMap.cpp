@@ -1,24 +1,108 @@
 #include "GridMap.h"
-#include <cstdlib>  // for rand()
-#include <ctime>
+#include "Rng.h"
+#include "ThreadPool.h"
+#include "MapFile.h"
+#include "Probe.h"
+#include <cmath>
 #include <algorithm>
 #include <vector>
 
+// Counter of the populateRandomFires stream; spread steps count up from 0
+static const uint64_t POPULATE_STREAM = ~0ULL;
+
 GridMap::GridMap(int r, int c)
-    : rows(r), cols(c)
+    : rows(r), cols(c), wordsPerRow((c + 63) / 64),
+      lastWordMask((c % 64) ? (1ULL << (c % 64)) - 1 : ~0ULL),
+      seed(0), spreadStep(0),
+      spreadMode(SpreadMode::Auto), sparseThreshold(0.4),
+      frontierValid(true), stampGeneration(0), queuedGeneration(1)
 {
-    grid.resize(rows, std::vector<char>(cols, ' '));
+    grid.assign((size_t)rows * cols, ' ');
+    fireBits.assign((size_t)rows * wordsPerRow, 0);
+    nextFireBits.assign((size_t)rows * wordsPerRow, 0);
+    wordStamp.assign((size_t)rows * wordsPerRow, 0);
+    queuedStamp.assign((size_t)rows * wordsPerRow, 0);
 }
 
+/*
+ * Each cell catches fire with probability fireChancePercent / 100, drawn
+ * from a generator keyed by the map's seed (its own stream, apart from the
+ * spread's). Instead of one draw per cell, a draw gives the gap to the next
+ * burning cell in row-major order, so a 10% map costs a draw per fire. Past
+ * 50% the draws pick the cells that stay clear instead, marked in the spread
+ * back buffer, and the rest of each word is ORed in. Fires already on the
+ * map are kept either way.
+ */
 void GridMap::populateRandomFires(int fireChancePercent)
 {
+    size_t cells = (size_t)rows * cols;
+    int percent = std::max(0, std::min(fireChancePercent, 100));
+    bool dense = percent > 50;
+    // Sparse: the drawn cells catch fire. Dense: they are noted as clear.
+    std::vector<uint64_t>& drawn = dense ? nextFireBits : fireBits;
+    if (dense) std::fill(nextFireBits.begin(), nextFireBits.end(), 0);
+    int chance = dense ? 100 - percent : percent;
+    if (chance > 0) {
+        Xoshiro256 rng(counterHash(seed, POPULATE_STREAM));
+        double logMiss = std::log1p(-chance / 100.0);
+        for (uint64_t cell = rng.skip(logMiss); cell < cells; cell += rng.skip(logMiss) + 1) {
+            int i = (int)(cell / cols), j = (int)(cell % cols);
+            drawn[(size_t)i * wordsPerRow + (j >> 6)] |= 1ULL << (j & 63);
+            if (!dense) grid[cell] = 'X';
+        }
+    }
+    if (dense) {
+        for (int i = 0; i < rows; i++) {
+            for (int w = 0; w < wordsPerRow; w++) {
+                size_t idx = (size_t)i * wordsPerRow + w;
+                uint64_t valid = w == wordsPerRow - 1 ? lastWordMask : ~0ULL;
+                uint64_t added = valid & ~nextFireBits[idx] & ~fireBits[idx];
+                fireBits[idx] |= added;
+                for (; added; added &= added - 1) {
+                    grid[index(i, w * 64 + __builtin_ctzll(added))] = 'X';
+                }
+            }
+        }
+    }
+    rebuildFrontier();
+}
+
+void GridMap::loadFires(const MapFile& file, int top, int left)
+{
+    std::fill(grid.begin(), grid.end(), ' ');
+    std::fill(fireBits.begin(), fireBits.end(), 0);
+    int fileWords = (file.getCols() + 63) / 64;
+    auto fileWord = [&](int row, long long word) -> uint64_t {
+        return word >= 0 && word < fileWords ? file.word(MAP_LAYER_FIRE, row, (int)word) : 0;
+    };
+    int shift = left & 63;
     for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            if (rand() % 100 < fireChancePercent) {
-                grid[i][j] = 'X';
+        long long fileRow = (long long)top + i;
+        if (fileRow < 0 || fileRow >= file.getRows()) continue;
+        uint64_t* out = fireBits.data() + (size_t)i * wordsPerRow;
+        for (int w = 0; w < wordsPerRow; w++) {
+            // 64 file columns starting at left + 64 w, which need not be aligned
+            long long word = ((long long)left >> 6) + w;
+            uint64_t bits = fileWord((int)fileRow, word) >> shift;
+            if (shift) bits |= fileWord((int)fileRow, word + 1) << (64 - shift);
+            if (w == wordsPerRow - 1) bits &= lastWordMask;
+            out[w] = bits;
+            while (bits) {
+                int j = w * 64 + __builtin_ctzll(bits);
+                grid[index(i, j)] = 'X';
+                bits &= bits - 1;
             }
         }
     }
+    rebuildFrontier();
+}
+
+void GridMap::clear()
+{
+    std::fill(grid.begin(), grid.end(), ' ');
+    std::fill(fireBits.begin(), fireBits.end(), 0);
+    lastIgnited.clear();
+    rebuildFrontier();
 }
 
 int GridMap::getRows() const {
@@ -29,57 +113,366 @@ int GridMap::getCols() const {
     return cols;
 }
 
-char GridMap::getCell(int row, int col) const {
-    return grid[row][col];
+void GridMap::setSeed(uint64_t s) {
+    seed = s;
+    spreadStep = 0;
+}
+
+const std::vector<int>& GridMap::getLastIgnited() const {
+    return lastIgnited;
+}
+
+void GridMap::setSpreadMode(SpreadMode mode) {
+    if (mode == spreadMode) return;
+    spreadMode = mode;
+    rebuildFrontier();
+}
+
+void GridMap::setSparseThreshold(double fraction) {
+    sparseThreshold = fraction;
 }
 
 void GridMap::setCell(int row, int col, char value) {
-    grid[row][col] = value;
+    grid[index(row, col)] = value;
+    uint64_t& word = fireBits[(size_t)row * wordsPerRow + (col >> 6)];
+    uint64_t bit = 1ULL << (col & 63);
+    uint64_t before = word;
+    if (value == 'X') {
+        word |= bit;
+    } else {
+        word &= ~bit;
+    }
+    if (word != before) {
+        touchFrontier(row, col);
+    }
+}
+
+// Per-call constants of the spread kernel.
+struct GridMap::SpreadParams {
+    uint64_t key;              // counter-RNG key for this call
+    uint64_t digitMask[53][9]; // all ones if the threshold for k neighbours has bit (52 - i) set
+    uint64_t alwaysMask[9];    // all ones if k neighbours ignite with certainty
+};
+
+// Bit-sliced adder: adds the 8 neighbour words lane by lane, so bit b of
+// (k0, k1, k2, k3) is the binary neighbour count of cell b.
+static inline void countNeighbors(const uint64_t n[8],
+                                  uint64_t& k0, uint64_t& k1, uint64_t& k2, uint64_t& k3)
+{
+    uint64_t s1 = n[0] ^ n[1] ^ n[2], c1 = (n[0] & n[1]) | (n[2] & (n[0] ^ n[1]));
+    uint64_t s2 = n[3] ^ n[4] ^ n[5], c2 = (n[3] & n[4]) | (n[5] & (n[3] ^ n[4]));
+    uint64_t s3 = n[6] ^ n[7],        c3 = n[6] & n[7];
+    k0 = s1 ^ s2 ^ s3;
+    uint64_t c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+    uint64_t t  = c1 ^ c2 ^ c3, c5 = (c1 & c2) | (c3 & (c1 ^ c2));
+    k1 = t ^ c4;
+    uint64_t c6 = t & c4;
+    k2 = c5 ^ c6;
+    k3 = c5 & c6;
+}
+
+/**
+ * spreadWord:
+ * Returns the mask of cells in word w of row r that catch fire this step.
+ *  - The 8-neighbourhood is built 64 cells at a time with word shifts;
+ *    cells in it that are not burning yet are the candidates.
+ *  - A candidate with k burning neighbours catches fire with probability
+ *    1 - (1 - spreadChance)^k, exactly what k independent rolls would give.
+ *  - All 64 rolls are done at once: each lane compares its own 53-bit
+ *    uniform number against its threshold one binary digit at a time,
+ *    drawing one random word per digit, and stops once every lane has
+ *    been decided (about 8 digits on average).
+ *  - Random words are counterHash(key, word index, digit), so the result
+ *    does not depend on which order words are visited in.
+ */
+uint64_t GridMap::spreadWord(int r, int w, const SpreadParams& params) const
+{
+    uint64_t left[3] = {0, 0, 0}, mid[3] = {0, 0, 0}, right[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        int rr = r + i - 1;
+        if (rr < 0 || rr >= rows) continue;
+        const uint64_t* row = fireRow(rr);
+        uint64_t x    = row[w];
+        uint64_t prev = w > 0 ? row[w - 1] : 0;
+        uint64_t next = w + 1 < wordsPerRow ? row[w + 1] : 0;
+        mid[i]   = x;
+        left[i]  = (x << 1) | (prev >> 63);   // lane b sees column b - 1
+        right[i] = (x >> 1) | (next << 63);   // lane b sees column b + 1
+    }
+    const uint64_t n[8] = { left[0], mid[0], right[0], left[1],
+                            right[1], left[2], mid[2], right[2] };
+
+    uint64_t candidates = (n[0] | n[1] | n[2] | n[3] | n[4] | n[5] | n[6] | n[7]) & ~mid[1];
+    if (w == wordsPerRow - 1) candidates &= lastWordMask;
+    if (!candidates) return 0;
+
+    uint64_t k0, k1, k2, k3;
+    countNeighbors(n, k0, k1, k2, k3);
+    uint64_t withK[9];
+    for (int k = 1; k <= 8; k++) {
+        withK[k] = candidates & ((k & 1) ? k0 : ~k0) & ((k & 2) ? k1 : ~k1)
+                              & ((k & 4) ? k2 : ~k2) & ((k & 8) ? k3 : ~k3);
+    }
+
+    uint64_t less = 0;
+    for (int k = 1; k <= 8; k++) {
+        less |= withK[k] & params.alwaysMask[k];
+    }
+    uint64_t undecided = candidates & ~less;
+    uint64_t counter = ((uint64_t)r * wordsPerRow + w) << 6;
+    for (int i = 0; i < 53 && undecided; i++) {
+        uint64_t digit = 0;
+        for (int k = 1; k <= 8; k++) {
+            digit |= withK[k] & params.digitMask[i][k];
+        }
+        uint64_t random = counterHash(params.key, counter + i);
+        less      |= undecided & ~random & digit;
+        undecided &= ~(random ^ digit);
+    }
+    return less;
+}
+
+void GridMap::spreadRows(int rowBegin, int rowEnd, const SpreadParams& params, std::vector<int>& ignitedCells)
+{
+    for (int r = rowBegin; r < rowEnd; r++) {
+        const uint64_t* cur = fireRow(r);
+        uint64_t* out = nextFireBits.data() + (size_t)r * wordsPerRow;
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t ignited = spreadWord(r, w, params);
+            out[w] = cur[w] | ignited;
+            while (ignited) {
+                int c = w * 64 + __builtin_ctzll(ignited);
+                ignited &= ignited - 1;
+                grid[index(r, c)] = 'X';
+                ignitedCells.push_back((int)index(r, c));
+            }
+        }
+    }
+}
+
+void GridMap::prepareSpread(double spreadChance, SpreadParams& params)
+{
+    params.key = counterHash(seed, spreadStep++);
+    for (int k = 0; k <= 8; k++) {
+        uint64_t threshold = probabilityThreshold(1.0 - std::pow(1.0 - spreadChance, k));
+        bool always = threshold >= (1ULL << 53);
+        params.alwaysMask[k] = always ? ~0ULL : 0;
+        for (int i = 0; i < 53; i++) {
+            bool set = !always && ((threshold >> (52 - i)) & 1);
+            params.digitMask[i][k] = set ? ~0ULL : 0;
+        }
+    }
+}
+
+// Burning cells of word w in row r that have at least one unburnt
+// neighbour. Cells outside the map count as burnt.
+uint64_t GridMap::frontierWord(int r, int w) const
+{
+    uint64_t fire = fireRow(r)[w];
+    if (!fire) return 0;
+    uint64_t open = 0;
+    for (int rr = r - 1; rr <= r + 1; rr++) {
+        if (rr < 0 || rr >= rows) continue;
+        const uint64_t* row = fireRow(rr);
+        uint64_t x    = ~row[w] & (w == wordsPerRow - 1 ? lastWordMask : ~0ULL);
+        uint64_t prev = w > 0 ? ~row[w - 1] : 0;
+        uint64_t next = w + 1 < wordsPerRow ? ~row[w + 1] & (w + 1 == wordsPerRow - 1 ? lastWordMask : ~0ULL) : 0;
+        open |= (x << 1) | (prev >> 63) | (x >> 1) | (next << 63);
+        if (rr != r) open |= x;
+    }
+    return fire & open;
+}
+
+// Starts a new pass over per-word stamps: a word is marked in this pass when
+// its stamp equals the generation. Wrapping around clears them all.
+static void nextGeneration(std::vector<uint32_t>& stamps, uint32_t& generation)
+{
+    if (++generation == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        generation = 1;
+    }
+}
+
+// Re-derive activeWords from the whole fire layer (one word-parallel pass).
+// Only kept if the front is small enough for the sparse path to pay off.
+void GridMap::rebuildFrontier()
+{
+    nextGeneration(queuedStamp, queuedGeneration);
+    activeWords.clear();
+    frontierValid = spreadMode != SpreadMode::Dense;
+    // Each active word makes up to 9 words to evaluate
+    size_t limit = (size_t)(sparseThreshold * rows * wordsPerRow / 9);
+    for (int r = 0; r < rows && frontierValid; r++) {
+        for (int w = 0; w < wordsPerRow; w++) {
+            if (!frontierWord(r, w)) continue;
+            if (activeWords.size() >= limit && spreadMode != SpreadMode::Sparse) {
+                frontierValid = false;
+                activeWords.clear();
+                break;
+            }
+            uint32_t idx = (uint32_t)((size_t)r * wordsPerRow + w);
+            queuedStamp[idx] = queuedGeneration;
+            activeWords.push_back(idx);
+        }
+    }
+}
+
+// A cell changed state outside spreadFires: the front can only have changed
+// in the words around it. Words already queued are not queued again, so
+// repeated edits between spread steps do not grow activeWords.
+void GridMap::touchFrontier(int row, int col)
+{
+    if (!frontierValid) return;
+    int w = col >> 6;
+    for (int r = std::max(0, row - 1); r <= std::min(rows - 1, row + 1); r++) {
+        for (int ww = std::max(0, w - 1); ww <= std::min(wordsPerRow - 1, w + 1); ww++) {
+            uint32_t idx = (uint32_t)((size_t)r * wordsPerRow + ww);
+            if (queuedStamp[idx] == queuedGeneration) continue;
+            queuedStamp[idx] = queuedGeneration;
+            activeWords.push_back(idx);
+        }
+    }
+}
+
+bool GridMap::useSparse() const
+{
+    if (!frontierValid || spreadMode == SpreadMode::Dense) return false;
+    if (spreadMode == SpreadMode::Sparse) return true;
+    return activeWords.size() * 9 < sparseThreshold * rows * wordsPerRow;
+}
+
+/**
+ * spreadSparse:
+ * Runs one spread step touching only the words around the active front.
+ *  - Every cell that can ignite has a burning neighbour, and that neighbour
+ *    is by definition on the front, so the candidate cells all lie in the
+ *    3x3 block of words around some active word.
+ *  - Those words go through the same spreadWord() as the dense sweep, so
+ *    the outcome is bit-identical; ignitions are applied to the fire layer
+ *    in place once all of them are known.
+ *  - The new front is a subset of the old front plus the cells that just
+ *    ignited, so only those words are re-checked.
+ */
+void GridMap::spreadSparse(const SpreadParams& params)
+{
+    // 1. Words that may contain candidates
+    nextGeneration(wordStamp, stampGeneration);
+    scratchWords.clear();
+    for (uint32_t idx : activeWords) {
+        int r = (int)(idx / wordsPerRow);
+        int w = (int)(idx % wordsPerRow);
+        for (int rr = std::max(0, r - 1); rr <= std::min(rows - 1, r + 1); rr++) {
+            for (int ww = std::max(0, w - 1); ww <= std::min(wordsPerRow - 1, w + 1); ww++) {
+                uint32_t n = (uint32_t)((size_t)rr * wordsPerRow + ww);
+                if (wordStamp[n] == stampGeneration) continue;
+                wordStamp[n] = stampGeneration;
+                scratchWords.push_back(n);
+            }
+        }
+    }
+
+    // 2. Roll them against the unchanged fire layer
+    scratchIgnitions.clear();
+    for (uint32_t idx : scratchWords) {
+        uint64_t ignited = spreadWord((int)(idx / wordsPerRow), (int)(idx % wordsPerRow), params);
+        if (ignited) scratchIgnitions.push_back({idx, ignited});
+    }
+
+    // 3. Apply, and collect the words whose front may have changed
+    for (auto& [idx, ignited] : scratchIgnitions) {
+        fireBits[idx] |= ignited;
+        size_t rowStart = (size_t)(idx / wordsPerRow) * cols;
+        int colBase = (int)(idx % wordsPerRow) * 64;
+        for (uint64_t bits = ignited; bits; bits &= bits - 1) {
+            size_t cell = rowStart + colBase + __builtin_ctzll(bits);
+            grid[cell] = 'X';
+            lastIgnited.push_back((int)cell);
+        }
+        activeWords.push_back(idx);
+    }
+    std::sort(lastIgnited.begin(), lastIgnited.end());
+
+    // 4. Keep only the words that still hold front cells
+    nextGeneration(wordStamp, stampGeneration);
+    nextGeneration(queuedStamp, queuedGeneration);
+    scratchWords.clear();
+    for (uint32_t idx : activeWords) {
+        if (wordStamp[idx] == stampGeneration) continue;
+        wordStamp[idx] = stampGeneration;
+        if (frontierWord((int)(idx / wordsPerRow), (int)(idx % wordsPerRow))) {
+            queuedStamp[idx] = queuedGeneration;
+            scratchWords.push_back(idx);
+        }
+    }
+    activeWords.swap(scratchWords);
 }
 
 /**
  * spreadFires:
  * For each cell that is on fire ('X'), we attempt to ignite its neighbors.
- *  - We make a copy of the grid first, so newly ignited fires do not
- *    themselves spread within the same iteration.
+ *  - The new fire layer is built in a preallocated back buffer and swapped
+ *    in, so newly ignited fires do not themselves spread within the same
+ *    iteration and nothing is copied or allocated per call.
  *  - 'spreadChance' is a float from 0.0 to 1.0 that controls how likely
- *    each neighbor will catch fire.
- *  - We check all 8 neighboring cells in this example. You can limit to 4 if desired.
+ *    each neighbor will catch fire, independently for every burning
+ *    neighbour it has.
+ *  - We check all 8 neighboring cells.
  */
 void GridMap::spreadFires(double spreadChance)
 {
-    // Create a copy of our current grid
-    std::vector<std::vector<char>> newGrid = grid;
+    PROBE_SCOPE("map.spread");
+    SpreadParams params;
+    prepareSpread(spreadChance, params);
+    lastIgnited.clear();
 
-    // Directions (8-neighbors)
-    int directions[8][2] = {
-        {-1, -1}, {-1, 0}, {-1, 1},
-        { 0, -1},           { 0, 1},
-        { 1, -1}, { 1, 0}, { 1, 1}
-    };
+    if (useSparse()) {
+        spreadSparse(params);
+        return;
+    }
 
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (grid[r][c] == 'X') {
-                // Try to ignite neighbors
-                for (auto &d : directions) {
-                    int nr = r + d[0];
-                    int nc = c + d[1];
-                    // Check bounds
-                    if (nr >= 0 && nr < rows && nc >= 0 && nc < cols) {
-                        // If neighbor is not already on fire, it might catch fire
-                        if (grid[nr][nc] != 'X') {
-                            double roll = (double)rand() / RAND_MAX; // random [0..1)
-                            if (roll < spreadChance) {
-                                newGrid[nr][nc] = 'X'; // ignite
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    spreadRows(0, rows, params, lastIgnited);
+
+    fireBits.swap(nextFireBits);
+    rebuildFrontier();
+}
+
+/**
+ * Parallel spreadFires:
+ * The grid is cut into bands of rows and each band is one pool task.
+ *  - A band reads its own rows plus one halo row above and below from the
+ *    current fire layer, which nobody writes during the step, so bands
+ *    never need to exchange anything.
+ *  - Each band writes only its own rows of the back buffer and char layer.
+ *  - Rolls are keyed by (seed, call, word), so the result is the same as
+ *    the serial call whatever the thread count or task order.
+ */
+void GridMap::spreadFires(double spreadChance, ThreadPool& pool)
+{
+    PROBE_SCOPE("map.spread");
+    SpreadParams params;
+    prepareSpread(spreadChance, params);
+    lastIgnited.clear();
+
+    // A small front is cheaper to walk on one thread than to hand out
+    if (useSparse()) {
+        spreadSparse(params);
+        return;
+    }
+
+    // Enough bands for stealing to even out the load, but each band still
+    // covers a few hundred KB of cells
+    const int bandRows = std::max(16, rows / (pool.size() * 8));
+    int bands = (rows + bandRows - 1) / bandRows;
+    if ((int)bandIgnited.size() < bands) bandIgnited.resize(bands);
+    pool.parallelFor(bands, [&](int band) {
+        int begin = band * bandRows;
+        bandIgnited[band].clear();
+        spreadRows(begin, std::min(rows, begin + bandRows), params, bandIgnited[band]);
+    });
+    for (int band = 0; band < bands; band++) {
+        lastIgnited.insert(lastIgnited.end(), bandIgnited[band].begin(), bandIgnited[band].end());
     }
 
-    // Copy newGrid back into grid
-    grid = newGrid;
+    fireBits.swap(nextFireBits);
+    rebuildFrontier();
 }
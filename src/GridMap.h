@@ -2,13 +2,35 @@
 #define GRIDMAP_H
 
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+class ThreadPool;
+class MapFile;
+
+// How spreadFires walks the map. Both modes give bit-identical results.
+//  Dense:  sweep every word of the fire layer.
+//  Sparse: visit only the words around the active front (burning cells that
+//          still have an unburnt neighbour); work scales with the front.
+//  Auto:   sparse while the front is small, dense once it is not.
+enum class SpreadMode { Auto, Dense, Sparse };
 
 class GridMap {
 public:
     // Constructor
     GridMap(int rows, int cols);
 
+    // Sets each cell on fire with the given chance, drawn from the seed
+    // (call setSeed first): the same seed and size give the same fires.
+    // Cells already on fire stay on fire.
     void populateRandomFires(int fireChancePercent);
+    // Takes the fires of the rows x cols window of 'file' whose top-left
+    // cell is (top, left); cells past the file's edge are clear. Only the
+    // tiles under the window are read.
+    void loadFires(const MapFile& file, int top, int left);
+    // Puts every fire out, keeping the buffers, so a map can be reused
+    void clear();
 
     int getRows() const;
     int getCols() const;
@@ -16,13 +38,94 @@ public:
     char getCell(int row, int col) const;
     void setCell(int row, int col, char value);
 
+    // Fast fire test backed by the bit layer (same answer as getCell(...) == 'X')
+    bool isFire(int row, int col) const;
+
+    // Bit-packed fire layer: bit (col % 64) of word (col / 64) is set when the
+    // cell is on fire. Every row starts on a fresh word so hot loops can scan
+    // a row 64 cells at a time; padding bits past the last column are always 0.
+    int getWordsPerRow() const;
+    const uint64_t* fireRow(int row) const;
+
     // fire spread
     void spreadFires(double spreadChance);
+    // Same result, with row bands spread in parallel on 'pool'. The output is
+    // bit-identical to the serial call for any number of threads.
+    void spreadFires(double spreadChance, ThreadPool& pool);
+
+    // Cells (row * cols + col) that caught fire in the last spreadFires call,
+    // in row-major order. Lets planners update only what changed.
+    const std::vector<int>& getLastIgnited() const;
+
+    // Switching mode re-derives the active front from the fire layer, so a
+    // map filled in one mode spreads the same in any other
+    void setSpreadMode(SpreadMode mode);
+    // In Auto mode, use the sparse path while the words around the front
+    // make up less than this fraction of the map (default 0.4).
+    void setSparseThreshold(double fraction);
+
+    // Seed for populateRandomFires and the spread RNG (default 0). Each
+    // spreadFires call draws from a counter-based generator keyed by (seed,
+    // call number, cell), so a given seed always produces the same initial
+    // map and the same sequence of fire maps, on any machine.
+    void setSeed(uint64_t seed);
 
 private:
-    std::vector<std::vector<char>> grid;
+    size_t index(int row, int col) const;
+    struct SpreadParams;
+    void prepareSpread(double spreadChance, SpreadParams& params);
+    uint64_t spreadWord(int row, int word, const SpreadParams& params) const;
+    void spreadRows(int rowBegin, int rowEnd, const SpreadParams& params, std::vector<int>& ignited);
+    void spreadSparse(const SpreadParams& params);
+    bool useSparse() const;
+    uint64_t frontierWord(int row, int word) const;
+    void rebuildFrontier();
+    void touchFrontier(int row, int col);
+
+    std::vector<char> grid;        // rows * cols, row-major
+    std::vector<uint64_t> fireBits; // rows * wordsPerRow
+    std::vector<uint64_t> nextFireBits; // back buffer for spreadFires
     int rows;
     int cols;
+    int wordsPerRow;
+    uint64_t lastWordMask;  // valid column bits of each row's last word
+    uint64_t seed;
+    uint64_t spreadStep;    // number of spreadFires calls so far
+    std::vector<int> lastIgnited;
+    std::vector<std::vector<int>> bandIgnited; // per-band deltas of the parallel path
+
+    // Sparse-mode bookkeeping
+    SpreadMode spreadMode;
+    double sparseThreshold;
+    bool frontierValid;                // activeWords covers every frontier cell
+    std::vector<uint32_t> activeWords; // fire-layer words that may hold frontier cells
+    std::vector<uint32_t> wordStamp;   // per word: last pass that queued it
+    uint32_t stampGeneration;
+    std::vector<uint32_t> queuedStamp; // per word: in activeWords since the list was last rebuilt
+    uint32_t queuedGeneration;
+    std::vector<uint32_t> scratchWords;
+    std::vector<std::pair<uint32_t, uint64_t>> scratchIgnitions;
 };
 
+// Accessors live in the header so the pathfinding loops can inline them.
+inline size_t GridMap::index(int row, int col) const {
+    return (size_t)row * cols + col;
+}
+
+inline char GridMap::getCell(int row, int col) const {
+    return grid[index(row, col)];
+}
+
+inline bool GridMap::isFire(int row, int col) const {
+    return (fireBits[(size_t)row * wordsPerRow + (col >> 6)] >> (col & 63)) & 1u;
+}
+
+inline int GridMap::getWordsPerRow() const {
+    return wordsPerRow;
+}
+
+inline const uint64_t* GridMap::fireRow(int row) const {
+    return fireBits.data() + (size_t)row * wordsPerRow;
+}
+
 #endif // GRIDMAP_H
@@ -0,0 +1,596 @@
+#include "Hpa.h"
+#include "Probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+namespace {
+
+const int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+const uint32_t STRAIGHT_COST = 10;
+const uint32_t DIAGONAL_COST = 14;
+const uint32_t INF = std::numeric_limits<uint32_t>::max();
+
+// Extra crossings along a border between the same two regions, so paths
+// do not have to detour to the one crossing of a long open border
+const int ENTRANCE_SPACING = 32;
+
+// Ends of a query in the cluster graph, which is otherwise keyed by cell
+const int START = -1;
+const int GOAL = -2;
+
+// Sides of a cluster, in the order Cluster::edge keeps them
+const int TOP = 0, BOTTOM = 1, LEFT = 2, RIGHT = 3;
+
+inline uint32_t octile(int r1, int c1, int r2, int c2) {
+    uint32_t dr = (uint32_t)std::abs(r1 - r2);
+    uint32_t dc = (uint32_t)std::abs(c1 - c2);
+    return dr < dc ? DIAGONAL_COST * dr + STRAIGHT_COST * (dc - dr)
+                   : DIAGONAL_COST * dc + STRAIGHT_COST * (dr - dc);
+}
+
+} // namespace
+
+HpaPlanner::HpaPlanner(int clusterSize)
+    : size(std::min(MAX_CLUSTER_SIZE, std::max(8, clusterSize))) {}
+
+// Starts over when asked about a different map
+void HpaPlanner::bind(const GridMap& m) {
+    if (map == &m && rows == m.getRows() && cols == m.getCols()) return;
+    map = &m;
+    rows = m.getRows();
+    cols = m.getCols();
+    clusterRows = (rows + size - 1) / size;
+    clusterCols = (cols + size - 1) / size;
+    clusters.assign((size_t)clusterRows * clusterCols, Cluster());
+    locals.clear();
+}
+
+void HpaPlanner::reset() {
+    map = nullptr;
+    clusters.clear();
+    locals.clear();
+    local.loaded = -1;
+    hpaStats = HpaStats();
+}
+
+int HpaPlanner::clusterOf(int cell) const {
+    int r = cell / cols;
+    int c = cell - r * cols;
+    return (r / size) * clusterCols + c / size;
+}
+
+void HpaPlanner::bounds(int k, int& r0, int& c0, int& r1, int& c1) const {
+    r0 = (k / clusterCols) * size;
+    c0 = (k % clusterCols) * size;
+    r1 = std::min(r0 + size, rows);
+    c1 = std::min(c0 + size, cols);
+}
+
+int HpaPlanner::nodeIndex(const Cluster& cluster, int cell) const {
+    auto it = std::find(cluster.nodes.begin(), cluster.nodes.end(), cell);
+    return it == cluster.nodes.end() ? -1 : (int)(it - cluster.nodes.begin());
+}
+
+int HpaPlanner::neighbours(int k, int out[4]) const {
+    int kr = k / clusterCols, kc = k % clusterCols;
+    int count = 0;
+    if (kr > 0) out[count++] = k - clusterCols;
+    if (kr + 1 < clusterRows) out[count++] = k + clusterCols;
+    if (kc > 0) out[count++] = k - 1;
+    if (kc + 1 < clusterCols) out[count++] = k + 1;
+    return count;
+}
+
+HpaPlanner::Cluster& HpaPlanner::ensure(int k) {
+    Cluster& cluster = clusters[k];
+    if (!cluster.built) {
+        int around[4];
+        int count = neighbours(k, around);
+        for (int i = 0; i < count; i++) {
+            if (!clusters[around[i]].labelled) label(around[i], local);
+        }
+        if (!cluster.labelled) label(k, local);
+        buildCluster(k, local);
+        hpaStats.builds++;
+        hpaStats.clusterSearches += cluster.nodes.empty() ? 0 : cluster.nodes.size() - 1;
+    }
+    return cluster;
+}
+
+// Copies the clear cells of cluster k into scratch.passable, framed by a
+// row and column of blocked cells so searches need no bounds checks
+void HpaPlanner::load(int k, Local& scratch) const {
+    int r0, c0, r1, c1;
+    bounds(k, r0, c0, r1, c1);
+    int width = size + 2;
+    scratch.passable.assign((size_t)width * width, 0);
+    for (int r = r0; r < r1; r++) {
+        uint8_t* row = &scratch.passable[(size_t)(r - r0 + 1) * width + 1];
+        for (int c = c0; c < c1; c++) row[c - c0] = !map->isFire(r, c);
+    }
+    scratch.loaded = k;
+}
+
+// Position of a cell of cluster k in the framed layout of load()
+int HpaPlanner::slot(int k, int cell) const {
+    int r = cell / cols, c = cell - r * cols;
+    return (r - (k / clusterCols) * size + 1) * (size + 2) + (c - (k % clusterCols) * size + 1);
+}
+
+// Numbers the 8-connected regions of clear cells in cluster k and keeps
+// the numbers of its border cells, which is all scanBorder() needs
+void HpaPlanner::label(int k, Local& scratch) {
+    load(k, scratch);
+    int width = size + 2;
+    int offsets[8];
+    for (int d = 0; d < 8; d++) offsets[d] = DIR[d][0] * width + DIR[d][1];
+    std::vector<uint16_t>& labels = scratch.labels;
+    labels.assign(scratch.passable.size(), 0);
+    int regions = 0;
+    for (size_t seed = 0; seed < labels.size(); seed++) {
+        if (labels[seed] || !scratch.passable[seed]) continue;
+        regions++;
+        labels[seed] = (uint16_t)regions;
+        scratch.stack.push_back((int)seed);
+        while (!scratch.stack.empty()) {
+            int at = scratch.stack.back();
+            scratch.stack.pop_back();
+            for (int offset : offsets) {
+                int next = at + offset;
+                if (labels[next] || !scratch.passable[next]) continue;
+                labels[next] = (uint16_t)regions;
+                scratch.stack.push_back(next);
+            }
+        }
+    }
+    int r0, c0, r1, c1;
+    bounds(k, r0, c0, r1, c1);
+    Cluster& cluster = clusters[k];
+    cluster.edge.assign((size_t)4 * size, 0);
+    for (int i = 0; i < c1 - c0; i++) {
+        cluster.edge[TOP * size + i] = labels[width + 1 + i];
+        cluster.edge[BOTTOM * size + i] = labels[(r1 - r0) * width + 1 + i];
+    }
+    for (int i = 0; i < r1 - r0; i++) {
+        cluster.edge[LEFT * size + i] = labels[(i + 1) * width + 1];
+        cluster.edge[RIGHT * size + i] = labels[(i + 1) * width + (c1 - c0)];
+    }
+    cluster.labelled = true;
+}
+
+// Crossings between cluster a and the cluster b below it ('below') or to
+// its right, as (cell in a, cell in b). Both clusters get the same list
+// from the same map, so their entrances always pair up.
+void HpaPlanner::scanBorder(int a, int b, bool below, std::vector<std::pair<int,int>>& crossings) const
+{
+    const uint16_t* labelsA = &clusters[a].edge[(below ? BOTTOM : RIGHT) * size];
+    const uint16_t* labelsB = &clusters[b].edge[(below ? TOP : LEFT) * size];
+    int ar0, ac0, ar1, ac1, br0, bc0, br1, bc1;
+    bounds(a, ar0, ac0, ar1, ac1);
+    bounds(b, br0, bc0, br1, bc1);
+    int length = below ? ac1 - ac0 : ar1 - ar0;
+    // Cell i along the border on a's side and on b's side
+    auto sideA = [&](int i, int& r, int& c) {
+        r = below ? ar1 - 1 : ar0 + i;
+        c = below ? ac0 + i : ac1 - 1;
+    };
+    auto sideB = [&](int i, int& r, int& c) {
+        r = below ? br0 : br0 + i;
+        c = below ? bc0 + i : bc0;
+    };
+    // Region pairs seen so far and where their last crossing was
+    std::vector<std::pair<uint32_t,int>> seen;
+    auto consider = [&](int i, int j, bool spaced) {
+        int ra, ca, rb, cb;
+        sideA(i, ra, ca);
+        sideB(j, rb, cb);
+        // Fire cells have no region
+        uint32_t key = (uint32_t)labelsA[i] << 16 | labelsB[j];
+        if (!labelsA[i] || !labelsB[j]) return;
+        auto it = std::find_if(seen.begin(), seen.end(),
+                               [&](const std::pair<uint32_t,int>& s) { return s.first == key; });
+        if (it == seen.end()) {
+            seen.push_back({key, i});
+        } else if (spaced && i - it->second >= ENTRANCE_SPACING) {
+            it->second = i;
+        } else {
+            return;
+        }
+        crossings.push_back({ra * cols + ca, rb * cols + cb});
+    };
+    for (int i = 0; i < length; i++) consider(i, i, true);
+    // Diagonal steps only matter where they join regions nothing else does
+    for (int i = 0; i + 1 < length; i++) {
+        consider(i, i + 1, false);
+        consider(i + 1, i, false);
+    }
+}
+
+// Needs the border labels of cluster k and of the clusters around it
+void HpaPlanner::buildCluster(int k, Local& scratch) {
+    PROBE_SCOPE("hpa.buildCluster");
+    Cluster& cluster = clusters[k];
+    cluster.nodes.clear();
+    cluster.links.clear();
+    int kr = k / clusterCols, kc = k % clusterCols;
+
+    std::vector<std::pair<int,int>> crossings;
+    auto addCrossings = [&](bool mineFirst) {
+        for (auto [a, b] : crossings) {
+            int mine = mineFirst ? a : b;
+            int other = mineFirst ? b : a;
+            int node = nodeIndex(cluster, mine);
+            if (node < 0) {
+                node = (int)cluster.nodes.size();
+                cluster.nodes.push_back(mine);
+            }
+            bool straight = mine / cols == other / cols || mine % cols == other % cols;
+            cluster.links.push_back({node, other, straight ? STRAIGHT_COST : DIAGONAL_COST});
+        }
+        crossings.clear();
+    };
+    if (kr > 0) {
+        scanBorder(k - clusterCols, k, true, crossings);
+        addCrossings(false);
+    }
+    if (kr + 1 < clusterRows) {
+        scanBorder(k, k + clusterCols, true, crossings);
+        addCrossings(true);
+    }
+    if (kc > 0) {
+        scanBorder(k - 1, k, false, crossings);
+        addCrossings(false);
+    }
+    if (kc + 1 < clusterCols) {
+        scanBorder(k, k + 1, false, crossings);
+        addCrossings(true);
+    }
+    // A diagonal step at a corner into the cluster across it. Only needed
+    // when both cells beside the step are on fire; otherwise the same way
+    // goes through one of the side clusters.
+    int r0, c0, r1, c1;
+    bounds(k, r0, c0, r1, c1);
+    for (int dr : {-1, 1}) {
+        for (int dc : {-1, 1}) {
+            int r = dr < 0 ? r0 : r1 - 1, c = dc < 0 ? c0 : c1 - 1;
+            int nr = r + dr, nc = c + dc;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols) continue;
+            if (map->isFire(r, c) || map->isFire(nr, nc)) continue;
+            if (!map->isFire(nr, c) || !map->isFire(r, nc)) continue;
+            crossings.push_back({r * cols + c, nr * cols + nc});
+        }
+    }
+    addCrossings(true);
+
+    // Costs between the entrances, one search from each; the costs are
+    // symmetric, so the last entrance needs no search of its own
+    size_t n = cluster.nodes.size();
+    cluster.dist.assign(n * n, INF);
+    for (size_t i = 0; i < n; i++) {
+        cluster.dist[i * n + i] = 0;
+        if (i + 1 == n) break;
+        searchCluster(k, cluster.nodes[i], -1, scratch, &cluster.nodes[i + 1], (int)(n - i - 1));
+        for (size_t j = i + 1; j < n; j++) {
+            int at = slot(k, cluster.nodes[j]);
+            if (scratch.stamp[at] != scratch.generation) continue;
+            cluster.dist[i * n + j] = cluster.dist[j * n + i] = scratch.cost[at];
+        }
+    }
+    cluster.built = true;
+}
+
+// Search from 'from' over the free cells of cluster k: Dijkstra over the
+// whole cluster when 'stop' is -1 (or until the 'count' cells in 'until'
+// are settled), otherwise A* that ends once 'stop' is settled. Costs and
+// parents are left in 'scratch', by position in the cluster.
+void HpaPlanner::searchCluster(int k, int from, int stop, Local& scratch, const int* until, int count) {
+    if (scratch.loaded != k) load(k, scratch);
+    int width = size + 2;
+    size_t cells = scratch.passable.size();
+    if (scratch.stamp.size() < cells) {
+        scratch.cost.assign(cells, 0);
+        scratch.stamp.assign(cells, 0);
+        scratch.wanted.assign(cells, 0);
+        scratch.parent.assign(cells, -1);
+        scratch.generation = 0;
+    }
+    if (++scratch.generation == 0) {
+        std::fill(scratch.stamp.begin(), scratch.stamp.end(), 0);
+        std::fill(scratch.wanted.begin(), scratch.wanted.end(), 0);
+        scratch.generation = 1;
+    }
+    for (int i = 0; i < count; i++) scratch.wanted[slot(k, until[i])] = scratch.generation;
+    int offsets[8];
+    uint32_t steps[8];
+    for (int d = 0; d < 8; d++) {
+        offsets[d] = DIR[d][0] * width + DIR[d][1];
+        steps[d] = DIR[d][0] && DIR[d][1] ? DIAGONAL_COST : STRAIGHT_COST;
+    }
+    int start = slot(k, from);
+    int target = stop >= 0 ? slot(k, stop) : -1;
+    int targetR = target / width, targetC = target % width;
+    auto heuristic = [&](int at) { return target >= 0 ? octile(at / width, at % width, targetR, targetC) : 0u; };
+    scratch.cost[start] = 0;
+    scratch.stamp[start] = scratch.generation;
+    scratch.parent[start] = -1;
+    for (auto& bucket : scratch.buckets) bucket.clear();
+    uint32_t f = heuristic(start);
+    scratch.buckets[f & 31].push_back(start);
+    size_t pending = 1;
+    while (pending > 0) {
+        std::vector<int>& bucket = scratch.buckets[f & 31];
+        if (bucket.empty()) {
+            f++;
+            continue;
+        }
+        int at = bucket.back();
+        bucket.pop_back();
+        pending--;
+        uint32_t g = scratch.cost[at];
+        // Stale entry: reached again later at a lower cost
+        if (g + heuristic(at) != f) continue;
+        if (at == target) break;
+        if (scratch.wanted[at] == scratch.generation) {
+            scratch.wanted[at] = 0;
+            if (--count == 0) break;
+        }
+        for (int d = 0; d < 8; d++) {
+            int next = at + offsets[d];
+            if (!scratch.passable[next]) continue;
+            uint32_t ng = g + steps[d];
+            if (scratch.stamp[next] == scratch.generation && scratch.cost[next] <= ng) continue;
+            scratch.stamp[next] = scratch.generation;
+            scratch.cost[next] = ng;
+            scratch.parent[next] = at;
+            scratch.buckets[(ng + heuristic(next)) & 31].push_back(next);
+            pending++;
+        }
+    }
+}
+
+void HpaPlanner::findPath(const GridMap& m, int startR, int startC, int goalR, int goalC,
+                          std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.hpa");
+    auto begin = std::chrono::steady_clock::now();
+    auto finish = [&]() {
+        ws.recordQuery((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    };
+    path.clear();
+    if (startR == goalR && startC == goalC) {
+        path.push_back({startR, startC});
+        finish();
+        return;
+    }
+    if (m.isFire(goalR, goalC)) {
+        finish();
+        return;
+    }
+    bind(m);
+    // Within a couple of clusters the detour through entrances costs more
+    // than it saves
+    if (octile(startR, startC, goalR, goalC) <= 2 * (uint32_t)size * STRAIGHT_COST) {
+        hpaStats.shortQueries++;
+        flat.findPath(m, startR, startC, goalR, goalC, path);
+        finish();
+        return;
+    }
+    int start = startR * cols + startC;
+    int goal = goalR * cols + goalC;
+    int ks = clusterOf(start), kg = clusterOf(goal);
+    // The map may have changed since the last query
+    local.loaded = -1;
+    const Cluster& first = ensure(ks);
+    const Cluster& last = ensure(kg);
+
+    // The ends join the graph through the entrances of their clusters
+    auto costsTo = [&](const Cluster& cluster, int k, std::vector<uint32_t>& costs) {
+        costs.assign(cluster.nodes.size(), INF);
+        for (size_t i = 0; i < cluster.nodes.size(); i++) {
+            int at = slot(k, cluster.nodes[i]);
+            if (local.stamp[at] == local.generation) costs[i] = local.cost[at];
+        }
+    };
+    searchCluster(ks, start, -1, local);
+    costsTo(first, ks, startCost);
+    searchCluster(kg, goal, -1, local);
+    costsTo(last, kg, goalCost);
+    hpaStats.clusterSearches += 2;
+
+    // A* over the entrances, with the octile distance to the goal
+    auto heuristic = [&](int id) {
+        if (id == GOAL) return 0u;
+        int cell = id == START ? start : id;
+        return octile(cell / cols, cell % cols, goalR, goalC);
+    };
+    states.clear();
+    open.clear();
+    auto relax = [&](int id, uint32_t g, int parent) {
+        auto [it, inserted] = states.try_emplace(id, State{g, parent});
+        if (!inserted) {
+            if (it->second.g <= g) return;
+            it->second = State{g, parent};
+        }
+        open.push_back((uint64_t)(g + heuristic(id)) << 32 | (uint32_t)id);
+        std::push_heap(open.begin(), open.end(), std::greater<uint64_t>());
+    };
+    relax(START, 0, START);
+    bool found = false;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<uint64_t>());
+        uint64_t top = open.back();
+        open.pop_back();
+        int id = (int)(uint32_t)top;
+        uint32_t g = states[id].g;
+        // Stale entry: reached again later at a lower cost
+        if ((uint32_t)(top >> 32) != g + heuristic(id)) continue;
+        ws.noteExpanded();
+        if (id == GOAL) {
+            found = true;
+            break;
+        }
+        if (id == START) {
+            for (size_t i = 0; i < first.nodes.size(); i++) {
+                if (startCost[i] != INF) relax(first.nodes[i], startCost[i], START);
+            }
+            continue;
+        }
+        int k = clusterOf(id);
+        const Cluster& cluster = ensure(k);
+        int i = nodeIndex(cluster, id);
+        if (i < 0) continue;
+        size_t n = cluster.nodes.size();
+        for (size_t j = 0; j < n; j++) {
+            uint32_t d = cluster.dist[i * n + j];
+            if (d != INF && (int)j != i) relax(cluster.nodes[j], g + d, id);
+        }
+        for (const Link& link : cluster.links) {
+            if (link.node == i) relax(link.cell, g + link.cost, id);
+        }
+        if (k == kg && goalCost[i] != INF) relax(GOAL, g + goalCost[i], id);
+    }
+    if (!found) {
+        // The graph keeps every way between regions, so the goal is cut off
+        finish();
+        return;
+    }
+
+    // Refine: a step across each border, a search inside each cluster
+    route.clear();
+    for (int id = GOAL; id != START; id = states[id].parent) route.push_back(id == GOAL ? goal : id);
+    std::reverse(route.begin(), route.end());
+    path.push_back({startR, startC});
+    int at = start;
+    for (int next : route) {
+        int k = clusterOf(at);
+        if (next == at) continue;
+        if (clusterOf(next) != k) {
+            path.push_back({next / cols, next % cols});
+            at = next;
+            continue;
+        }
+        searchCluster(k, at, next, local);
+        hpaStats.clusterSearches++;
+        int r0, c0, r1, c1;
+        bounds(k, r0, c0, r1, c1);
+        int end = slot(k, next);
+        if (local.stamp[end] != local.generation) {
+            // The cluster graph is out of date with the map; should not happen
+            // while every fire is reported through cellsBlocked()
+            hpaStats.fallbacks++;
+            flat.findPath(m, startR, startC, goalR, goalC, path);
+            finish();
+            return;
+        }
+        size_t mark = path.size();
+        for (int cell = end; local.parent[cell] >= 0; cell = local.parent[cell]) {
+            path.push_back({r0 + cell / (size + 2) - 1, c0 + cell % (size + 2) - 1});
+        }
+        std::reverse(path.begin() + mark, path.end());
+        at = next;
+    }
+    finish();
+}
+
+void HpaPlanner::cellsBlocked(const std::vector<int>& cells) {
+    if (!map) return;
+    auto drop = [&](int k) {
+        if (clusters[k].built) {
+            clusters[k].built = false;
+            hpaStats.invalidations++;
+        }
+    };
+    for (int cell : cells) {
+        int k = clusterOf(cell);
+        // Its regions may have split; the entrances it shares with the
+        // clusters around it may have changed
+        clusters[k].labelled = false;
+        drop(k);
+        int around[4];
+        int count = neighbours(k, around);
+        for (int i = 0; i < count; i++) drop(around[i]);
+        // A corner cell also decides the corner steps of the clusters
+        // diagonal to it
+        int r = (cell / cols) % size, c = (cell % cols) % size;
+        if ((r == 0 || r == size - 1) && (c == 0 || c == size - 1)) {
+            int kr = k / clusterCols, kc = k % clusterCols;
+            for (int dr = -1; dr <= 1; dr += 2) {
+                for (int dc = -1; dc <= 1; dc += 2) {
+                    int nr = kr + dr, nc = kc + dc;
+                    if (nr >= 0 && nr < clusterRows && nc >= 0 && nc < clusterCols) drop(nr * clusterCols + nc);
+                }
+            }
+        }
+    }
+}
+
+void HpaPlanner::build(const GridMap& m, ThreadPool& pool) {
+    bind(m);
+    // Built clusters and the searches that built them, before and after
+    auto count = [&](size_t& built, size_t& searches) {
+        built = searches = 0;
+        for (const Cluster& cluster : clusters) {
+            if (!cluster.built) continue;
+            built++;
+            searches += cluster.nodes.empty() ? 0 : cluster.nodes.size() - 1;
+        }
+    };
+    size_t builtBefore, searchesBefore;
+    count(builtBefore, searchesBefore);
+    // A band of clusters per task; each task takes a scratch space of its
+    // own. Every cluster is labelled before any is built, as building reads
+    // the labels of the clusters around.
+    auto eachBand = [&](bool labelling) {
+        pool.parallelFor(clusterRows, [&](int kr) {
+            std::unique_ptr<Local> scratch;
+            {
+                std::lock_guard<std::mutex> guard(localLock);
+                if (!locals.empty()) {
+                    scratch = std::move(locals.back());
+                    locals.pop_back();
+                }
+            }
+            if (!scratch) scratch = std::make_unique<Local>();
+            scratch->loaded = -1;
+            for (int kc = 0; kc < clusterCols; kc++) {
+                int k = kr * clusterCols + kc;
+                if (labelling && !clusters[k].labelled) label(k, *scratch);
+                if (!labelling && !clusters[k].built) buildCluster(k, *scratch);
+            }
+            std::lock_guard<std::mutex> guard(localLock);
+            locals.push_back(std::move(scratch));
+        });
+    };
+    eachBand(true);
+    eachBand(false);
+    size_t builtAfter, searchesAfter;
+    count(builtAfter, searchesAfter);
+    hpaStats.builds += builtAfter - builtBefore;
+    hpaStats.clusterSearches += searchesAfter - searchesBefore;
+}
+
+size_t HpaPlanner::entranceCount() const {
+    size_t total = 0;
+    for (const Cluster& cluster : clusters) {
+        if (cluster.built) total += cluster.nodes.size();
+    }
+    return total;
+}
+
+size_t HpaPlanner::edgeCount() const {
+    size_t total = 0;
+    for (const Cluster& cluster : clusters) {
+        if (!cluster.built) continue;
+        total += cluster.links.size();
+        size_t n = cluster.nodes.size();
+        for (size_t i = 0; i < n * n; i++) {
+            total += cluster.dist[i] != INF && i % (n + 1) != 0;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,132 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "GridMap.h"
+#include "Pathfinding.h"
+#include "ThreadPool.h"
+
+// Hierarchical pathfinding (HPA*). The map is cut into square clusters;
+// a search runs on a small graph of entrance cells and is then refined
+// inside one cluster at a time, so a long leg costs about as much as the
+// clusters along it rather than the cells.
+//  - Entrances: where two clusters touch, adjacent free cells across the
+//    border are possible crossings. Each pair of connected regions (one on
+//    each side) gets a crossing, plus one every ENTRANCE_SPACING cells along
+//    the border, so the graph stays small but every way through is kept.
+//    A corner step into a diagonal cluster is a crossing only when both
+//    cells beside it are on fire, as it is the only way through then.
+//  - Each cluster stores the cost between every two of its entrances,
+//    found with one search per entrance inside the cluster.
+//  - Clusters are built when a search first reaches them, or all at once
+//    on a pool with build(). A fire invalidates its cluster and the four
+//    around it (their shared entrances may change); they are rebuilt when
+//    next needed.
+// Paths are valid and usually within a few percent of the best. Queries
+// within two clusters go to flat A*.
+class HpaPlanner : public PathPlanner {
+public:
+    struct HpaStats {
+        uint64_t builds = 0;            // clusters (re)built
+        uint64_t invalidations = 0;     // clusters dropped by fires
+        uint64_t clusterSearches = 0;   // searches inside one cluster
+        uint64_t shortQueries = 0;      // queries short enough for flat A*
+        uint64_t fallbacks = 0;         // refinements that failed (map changed unreported)
+    };
+
+    // clusterSize is clamped to 8..MAX_CLUSTER_SIZE
+    explicit HpaPlanner(int clusterSize = 64);
+
+    // Region labels are 16-bit; a cluster this size has at most
+    // 256 * 256 / 4 regions, well within them
+    static const int MAX_CLUSTER_SIZE = 256;
+
+    const char* name() const override { return "hpa"; }
+    void findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                  std::vector<std::pair<int,int>>& path) override;
+    void cellsBlocked(const std::vector<int>& cells) override;
+    // Drops every cluster and the stats; the next query binds afresh
+    void reset() override;
+
+    // Builds every cluster of 'map' now, in parallel on 'pool'
+    void build(const GridMap& map, ThreadPool& pool);
+
+    const HpaStats& getHpaStats() const { return hpaStats; }
+    size_t clusterCount() const { return clusters.size(); }
+    // Entrances in the built clusters, and their edges
+    size_t entranceCount() const;
+    size_t edgeCount() const;
+
+private:
+    struct Link {
+        int node;           // index of the entrance in this cluster
+        int cell;           // the cell across the border
+        uint32_t cost;      // straight or diagonal step
+    };
+    struct Cluster {
+        bool built = false;
+        bool labelled = false;
+        std::vector<uint16_t> edge;     // region of each border cell, 0 = fire
+        std::vector<int> nodes;         // entrance cells
+        std::vector<Link> links;
+        std::vector<uint32_t> dist;     // nodes x nodes costs inside the cluster
+    };
+    // Scratch space for searches inside one cluster, one per thread
+    struct Local {
+        std::vector<uint8_t> passable;      // see load()
+        int loaded = -1;                    // the cluster in 'passable'
+        std::vector<int> stack;
+        std::vector<uint32_t> cost;
+        std::vector<uint32_t> stamp;
+        std::vector<uint32_t> wanted;       // stamped: cells still to settle
+        std::vector<int> parent;
+        // Open cells by f, a ring of buckets: a step raises f by at most
+        // 2 * DIAGONAL_COST, so 32 are enough
+        std::vector<int> buckets[32];
+        uint32_t generation = 0;
+        std::vector<uint16_t> labels;
+    };
+
+    void bind(const GridMap& map);
+    int clusterOf(int cell) const;
+    void bounds(int k, int& r0, int& c0, int& r1, int& c1) const;
+    Cluster& ensure(int k);
+    void buildCluster(int k, Local& local);
+    void load(int k, Local& local) const;
+    int slot(int k, int cell) const;
+    int neighbours(int k, int out[4]) const;
+    void label(int k, Local& local);
+    void scanBorder(int a, int b, bool below, std::vector<std::pair<int,int>>& crossings) const;
+    void searchCluster(int k, int from, int stop, Local& local,
+                       const int* until = nullptr, int count = 0);
+    int nodeIndex(const Cluster& cluster, int cell) const;
+
+    int size;
+    const GridMap* map = nullptr;
+    int rows = 0, cols = 0;
+    int clusterRows = 0, clusterCols = 0;
+    std::vector<Cluster> clusters;
+    Local local;                    // for queries
+    // For build(): one per concurrent task, like Fleet's workspaces
+    std::mutex localLock;
+    std::vector<std::unique_ptr<Local>> locals;
+
+    // Abstract search state
+    struct State {
+        uint32_t g;
+        int parent;
+    };
+    std::unordered_map<int, State> states;
+    std::vector<uint64_t> open;
+    std::vector<uint32_t> startCost, goalCost;
+    std::vector<int> route;
+    AStarPlanner flat;
+    HpaStats hpaStats;
+};
+
+#endif // HPA_H
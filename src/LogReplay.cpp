@@ -0,0 +1,120 @@
+// Reads mission logs written by DroneClient --log and BaseStationServer --log.
+//
+//   LogReplay LOG
+//       the log's size, its events by type and the final state
+//   LogReplay LOG --at N [--map]
+//       the state after the first N events (the drones' positions, cells
+//       seen, fires found); --map draws the map as it was then
+//   LogReplay LOG --seeks K
+//       times K seeks to random events
+//
+// The log is mapped, not read, and indexed once with snapshots of the
+// state along the way, so a seek replays only from the snapshot before it.
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "MissionLog.h"
+#include "MapRenderer.h"
+#include "Rng.h"
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printState(const ReplayState& state)
+{
+    std::cout << "After " << state.events << " events: " << state.moves << " moves, "
+              << state.spreads << " spread steps, " << state.messages << " messages ("
+              << state.messageBytes << " bytes)\n"
+              << "  " << state.count(state.seen) << " cells seen, " << state.count(state.found)
+              << " fires found, " << state.count(state.fire) << " cells burning\n";
+    for (size_t k = 0; k < state.drones.size(); k++) {
+        if (state.drones[k].first < 0) continue;
+        std::cout << "  drone " << k << " at (" << state.drones[k].first << "," << state.drones[k].second << ")\n";
+    }
+}
+
+void drawMap(const ReplayState& state)
+{
+    std::vector<char> occupied((size_t)state.rows * state.cols, 0);
+    for (auto [r, c] : state.drones) {
+        if (r >= 0) occupied[(size_t)r * state.cols + c] = 1;
+    }
+    MapRenderer renderer(state.rows, state.cols, 0, "DX?");
+    renderer.draw("=== Map after " + std::to_string(state.events) + " events ===", [&](int r, int c) {
+        if (!state.get(state.seen, r, c)) return '?';
+        if (occupied[(size_t)r * state.cols + c]) return 'D';
+        return state.get(state.fire, r, c) || state.get(state.found, r, c) ? 'X' : ' ';
+    }, true);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    long long at = -1;
+    bool map = false;
+    int seeks = 0;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--at" && i + 1 < argc) at = std::max(0LL, std::atoll(argv[++i]));
+        else if (arg == "--map") map = true;
+        else if (arg == "--seeks" && i + 1 < argc) seeks = std::max(1, std::atoi(argv[++i]));
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else usage = true;
+    }
+    if (usage || path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " LOG [--at N [--map]] [--seeks K]\n";
+        return 1;
+    }
+
+    MissionReplay replay;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    if (!replay.open(path, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    double indexMs = msSince(start);
+    std::cout << std::fixed << std::setprecision(1)
+              << path << ": " << replay.getRows() << " x " << replay.getCols() << ", seed "
+              << replay.getSeed() << ", " << replay.getBytes() << " bytes, " << replay.getEvents() << " events\n";
+    const char* names[] = {"", "fires", "move", "scan", "cells", "spread", "message"};
+    std::cout << " ";
+    for (int t = 1; t <= 6; t++) std::cout << " " << names[t] << " " << replay.getTypeCounts()[t];
+    std::cout << "\n  indexed in " << indexMs << " ms ("
+              << (indexMs > 0 ? replay.getEvents() / indexMs / 1000 : 0.0) << " M events/s), "
+              << replay.getSnapshots() << " snapshots\n";
+
+    ReplayState state;
+    if (seeks > 0) {
+        Xoshiro256 rng(1);
+        double total = 0, worst = 0;
+        for (int i = 0; i < seeks; i++) {
+            uint64_t event = replay.getEvents() ? rng.next() % (replay.getEvents() + 1) : 0;
+            auto seekStart = std::chrono::steady_clock::now();
+            replay.seek(event, state);
+            double ms = msSince(seekStart);
+            total += ms;
+            worst = std::max(worst, ms);
+        }
+        std::cout << std::setprecision(3) << "  " << seeks << " seeks: " << total / seeks
+                  << " ms mean, " << worst << " ms max\n";
+    }
+
+    replay.seek(at < 0 ? UINT64_MAX : (uint64_t)at, state);
+    printState(state);
+    if (map) drawMap(state);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Builds tiled map files for DroneClient --map.
+//
+//   MapConvert INPUT OUTPUT
+//       INPUT is a raster, one line per row. With commas it is CSV: a
+//       field is a fire if it is a non-zero number or X. Without commas
+//       every character is a cell and X marks a fire. The first line sets
+//       the width; shorter lines are padded with clear cells.
+//   MapConvert --random ROWS COLS PERCENT SEED OUTPUT
+//       a seeded random fire map of any size, written band by band
+//   MapConvert --info FILE
+//       prints the size, layers and fire count of a map file
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+#include "MapFile.h"
+
+namespace {
+
+// Splits a raster line into cells; true for fires
+void parseLine(const std::string& line, std::vector<bool>& cells)
+{
+    cells.clear();
+    if (line.find(',') == std::string::npos) {
+        for (char ch : line) {
+            if (ch == '\r') continue;
+            cells.push_back(ch == 'X' || ch == 'x');
+        }
+        return;
+    }
+    size_t pos = 0;
+    while (pos <= line.size()) {
+        size_t comma = line.find(',', pos);
+        if (comma == std::string::npos) comma = line.size();
+        std::string field = line.substr(pos, comma - pos);
+        size_t first = field.find_first_not_of(" \t\r");
+        size_t last = field.find_last_not_of(" \t\r");
+        field = first == std::string::npos ? "" : field.substr(first, last - first + 1);
+        bool fire = field == "X" || field == "x" || (!field.empty() && std::atof(field.c_str()) != 0);
+        cells.push_back(fire);
+        pos = comma + 1;
+    }
+}
+
+int convert(const std::string& input, const std::string& output)
+{
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "Cannot open " << input << "\n";
+        return 1;
+    }
+    MapFileWriter writer;
+    std::string line, error;
+    std::vector<bool> cells;
+    int cols = 0;
+    uint64_t fires = 0, cut = 0;
+    while (std::getline(in, line)) {
+        parseLine(line, cells);
+        if (cols == 0) {
+            if (cells.empty()) continue;
+            cols = (int)cells.size();
+            if (!writer.create(output, cols, 1, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+        }
+        if ((int)cells.size() > cols) cut++;
+        uint64_t* bits = writer.row(MAP_LAYER_FIRE);
+        for (int c = 0; c < cols && c < (int)cells.size(); c++) {
+            if (!cells[c]) continue;
+            bits[c >> 6] |= 1ULL << (c & 63);
+            fires++;
+        }
+        if (!writer.nextRow()) break;
+    }
+    if (cols == 0) {
+        std::cerr << input << " has no cells\n";
+        return 1;
+    }
+    if (!writer.close()) {
+        std::cerr << "Cannot write " << output << "\n";
+        return 1;
+    }
+    if (cut) std::cerr << cut << " rows were longer than the first and were cut\n";
+    std::cout << output << ": " << writer.getRows() << " x " << cols << ", " << fires << " fire cells\n";
+    return 0;
+}
+
+int info(const std::string& path)
+{
+    MapFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    uint64_t fires = 0;
+    int words = (file.getCols() + 63) / 64;
+    for (int r = 0; r < file.getRows(); r++) {
+        for (int w = 0; w < words; w++) {
+            fires += (uint64_t)__builtin_popcountll(file.word(MAP_LAYER_FIRE, r, w));
+        }
+        // Keep memory flat on maps larger than it
+        if ((r & 4095) == 4095) file.releasePages();
+    }
+    std::cout << path << ": " << file.getRows() << " x " << file.getCols()
+              << ", " << file.getLayers() << " layer(s), " << fires << " fire cells\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--info" && argc == 3) {
+        return info(argv[2]);
+    }
+    if (mode == "--random" && argc == 7) {
+        std::string error;
+        if (!writeRandomMapFile(argv[6], std::atoi(argv[2]), std::atoi(argv[3]), std::atoi(argv[4]),
+                                std::strtoull(argv[5], nullptr, 10), error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        return info(argv[6]);
+    }
+    if (argc == 3 && mode.rfind("--", 0) != 0) {
+        return convert(argv[1], argv[2]);
+    }
+    std::cerr << "Usage: " << argv[0] << " INPUT OUTPUT\n"
+              << "       " << argv[0] << " --random ROWS COLS PERCENT SEED OUTPUT\n"
+              << "       " << argv[0] << " --info FILE\n"
+              << "INPUT is a CSV raster (non-zero or X = fire) or a text raster (X = fire),\n"
+              << "one line per row.\n";
+    return 1;
+}
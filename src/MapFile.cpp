@@ -0,0 +1,264 @@
+#include "MapFile.h"
+#include "Rng.h"
+
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Header fields, at fixed offsets; the format is little-endian like the
+// machines it runs on, so fields are copied as they are
+namespace {
+
+const char MAGIC[8] = {'F', 'I', 'R', 'E', 'M', 'A', 'P', '1'};
+
+struct Header {
+    uint32_t version;
+    uint32_t tile;
+    uint64_t rows;
+    uint64_t cols;
+    uint32_t layers;
+};
+
+void encodeHeader(const Header& h, char* out) {
+    memset(out, 0, MAP_FILE_HEADER);
+    memcpy(out, MAGIC, 8);
+    memcpy(out + 8, &h.version, 4);
+    memcpy(out + 12, &h.tile, 4);
+    memcpy(out + 16, &h.rows, 8);
+    memcpy(out + 24, &h.cols, 8);
+    memcpy(out + 32, &h.layers, 4);
+}
+
+bool decodeHeader(const char* in, Header& h) {
+    if (memcmp(in, MAGIC, 8) != 0) return false;
+    memcpy(&h.version, in + 8, 4);
+    memcpy(&h.tile, in + 12, 4);
+    memcpy(&h.rows, in + 16, 8);
+    memcpy(&h.cols, in + 24, 8);
+    memcpy(&h.layers, in + 32, 4);
+    return true;
+}
+
+// Bytes of tile data a rows x cols map with 'layers' layers needs
+uint64_t tileBytes(uint64_t rows, uint64_t cols, uint64_t layers) {
+    uint64_t tiles = ((rows + MAP_TILE - 1) / MAP_TILE) * ((cols + MAP_TILE - 1) / MAP_TILE);
+    return tiles * layers * MAP_TILE * sizeof(uint64_t);
+}
+
+} // namespace
+
+MapFile::~MapFile() {
+    close();
+}
+
+bool MapFile::open(const std::string& path, std::string& error) {
+    close();
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(fh, &size);
+    length = (size_t)size.QuadPart;
+    HANDLE mh = length >= MAP_FILE_HEADER ? CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    void* view = mh ? MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mh) CloseHandle(mh);
+        CloseHandle(fh);
+        error = path + " is not a map file";
+        return false;
+    }
+    fileHandle = fh;
+    mappingHandle = mh;
+    base = view;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < MAP_FILE_HEADER) {
+        ::close(fd);
+        error = path + " is not a map file";
+        return false;
+    }
+    length = (size_t)st.st_size;
+    void* view = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);    // the mapping keeps the file open
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    // Searches jump around the map: read only the pages that are touched
+    // rather than reading ahead along the file
+    madvise(view, length, MADV_RANDOM);
+    base = view;
+#endif
+
+    Header h;
+    const char* bytes = (const char*)base;
+    bool valid = decodeHeader(bytes, h);
+    if (!valid) {
+        error = path + " is not a map file";
+    } else if (h.version != MAP_FILE_VERSION || h.tile != MAP_TILE) {
+        error = path + " has an unsupported map version or tile size";
+        valid = false;
+    } else if (h.rows == 0 || h.cols == 0 || h.rows > INT_MAX || h.cols > INT_MAX ||
+               h.layers == 0 || h.layers > 64) {
+        error = path + " has a bad map size";
+        valid = false;
+    } else if (length - MAP_FILE_HEADER < tileBytes(h.rows, h.cols, h.layers)) {
+        error = path + " is truncated";
+        valid = false;
+    }
+    if (!valid) {
+        close();
+        return false;
+    }
+    rows = (int)h.rows;
+    cols = (int)h.cols;
+    layers = (int)h.layers;
+    tilesPerRow = (cols + MAP_TILE - 1) / MAP_TILE;
+    tiles = (const uint64_t*)(bytes + MAP_FILE_HEADER);
+    return true;
+}
+
+void MapFile::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mappingHandle = fileHandle = nullptr;
+#else
+    munmap(base, length);
+#endif
+    base = nullptr;
+    tiles = nullptr;
+    length = 0;
+    rows = cols = layers = tilesPerRow = 0;
+}
+
+void MapFile::releasePages() {
+    if (!base) return;
+#ifdef _WIN32
+    // Unlocking pages that were never locked takes them out of the working set
+    VirtualUnlock(base, length);
+#else
+    // The mapping is read-only and shared, so this only forgets the pages;
+    // the file is untouched
+    madvise(base, length, MADV_DONTNEED);
+#endif
+}
+
+MapFileWriter::~MapFileWriter() {
+    if (file) close();
+}
+
+bool MapFileWriter::create(const std::string& path, int c, int l, std::string& error) {
+    if (c <= 0 || l <= 0 || l > 64) {
+        error = "bad map size";
+        return false;
+    }
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    cols = c;
+    layers = l;
+    wordsPerRow = (cols + MAP_TILE - 1) / MAP_TILE;
+    rows = 0;
+    failed = false;
+    current.assign((size_t)wordsPerRow * layers, 0);
+    band.assign((size_t)wordsPerRow * layers * MAP_TILE, 0);
+    // Room for the header; close() fills it in
+    std::vector<char> header(MAP_FILE_HEADER, 0);
+    failed = std::fwrite(header.data(), 1, header.size(), file) != header.size();
+    return !failed;
+}
+
+bool MapFileWriter::nextRow() {
+    // Bits past the last column stay 0 whatever the caller left there
+    uint64_t lastMask = (cols % 64) ? (1ULL << (cols % 64)) - 1 : ~0ULL;
+    int r = rows & (MAP_TILE - 1);
+    for (int layer = 0; layer < layers; layer++) {
+        const uint64_t* src = row(layer);
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t bits = w == wordsPerRow - 1 ? src[w] & lastMask : src[w];
+            band[((size_t)w * layers + layer) * MAP_TILE + r] = bits;
+        }
+    }
+    std::fill(current.begin(), current.end(), 0);
+    rows++;
+    if (r == MAP_TILE - 1) return writeBand();
+    return !failed;
+}
+
+bool MapFileWriter::writeBand() {
+    if (!failed) {
+        failed = std::fwrite(band.data(), sizeof(uint64_t), band.size(), file) != band.size();
+    }
+    std::fill(band.begin(), band.end(), 0);
+    return !failed;
+}
+
+bool MapFileWriter::close() {
+    if (!file) return false;
+    if (rows % MAP_TILE != 0) writeBand();
+    Header h{(uint32_t)MAP_FILE_VERSION, (uint32_t)MAP_TILE, (uint64_t)rows, (uint64_t)cols, (uint32_t)layers};
+    std::vector<char> header(MAP_FILE_HEADER);
+    encodeHeader(h, header.data());
+    if (!failed) {
+        failed = std::fseek(file, 0, SEEK_SET) != 0 ||
+                 std::fwrite(header.data(), 1, header.size(), file) != header.size();
+    }
+    failed = std::fclose(file) != 0 || failed;
+    file = nullptr;
+    return !failed && rows > 0;
+}
+
+bool writeRandomMapFile(const std::string& path, int rows, int cols, int percent,
+                        uint64_t seed, std::string& error)
+{
+    MapFileWriter writer;
+    if (rows <= 0 || !writer.create(path, cols, 1, error)) {
+        if (rows <= 0) error = "bad map size";
+        return false;
+    }
+    // One draw covers 8 cells, a byte each, so the chance is in 256ths
+    uint32_t threshold = (uint32_t)(std::max(0, std::min(percent, 100)) * 256 + 50) / 100;
+    int words = (cols + 63) / 64;
+    for (int r = 0; r < rows; r++) {
+        uint64_t* bits = writer.row(MAP_LAYER_FIRE);
+        for (int w = 0; w < words; w++) {
+            uint64_t word = 0;
+            for (int part = 0; part < 8; part++) {
+                uint64_t h = counterHash(seed, ((uint64_t)r * words + w) * 8 + part);
+                for (int b = 0; b < 8; b++) {
+                    if (((h >> (8 * b)) & 0xFF) < threshold) word |= 1ULL << (part * 8 + b);
+                }
+            }
+            bits[w] = word;
+        }
+        if (!writer.nextRow()) break;
+    }
+    if (!writer.close()) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
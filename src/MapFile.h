@@ -0,0 +1,120 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+// Tiled map file, opened with mmap so a grid can be far larger than memory:
+// the OS reads a tile from disk the first time the drone or a planner looks
+// at it, and can drop it again under memory pressure.
+//
+//   header, MAP_FILE_HEADER bytes: "FIREMAP1", u32 version, u32 tile size
+//          (always 64), u64 rows, u64 cols, u32 layers, zero padding
+//   tiles:  row-major over the tile grid; a tile holds one 64x64 bit plane
+//           per layer, 64 little-endian words, bit (col % 64) of word
+//           (row % 64) for each cell. Cells past the map edge are 0.
+//
+// The header is page-sized so every tile starts on its own 512-byte block
+// and a page holds whole tiles.
+const int MAP_FILE_VERSION = 1;
+const int MAP_TILE = 64;
+const size_t MAP_FILE_HEADER = 4096;
+
+// Layer 0 is the fire layer; later layers are for other rasters (terrain,
+// fuel) and are carried along untouched for now
+const int MAP_LAYER_FIRE = 0;
+
+class MapFile {
+public:
+    MapFile() = default;
+    ~MapFile();
+
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+
+    // Maps 'path' read-only. False, with 'error' set, if it cannot be
+    // opened, is not a map file or is shorter than its header says.
+    bool open(const std::string& path, std::string& error);
+    void close();
+    bool isOpen() const { return tiles != nullptr; }
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getLayers() const { return layers; }
+
+    bool get(int layer, int row, int col) const;
+    bool isFire(int row, int col) const { return get(MAP_LAYER_FIRE, row, col); }
+    // Cells [64 * tileCol, 64 * tileCol + 64) of 'row', one bit each
+    uint64_t word(int layer, int row, int tileCol) const;
+
+    // Drops every mapped page from this process; tiles are read back in
+    // (from the page cache, or disk) when they are next touched
+    void releasePages();
+
+private:
+    const uint64_t* tiles = nullptr;    // first tile, just past the header
+    void* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    int rows = 0, cols = 0, layers = 0;
+    int tilesPerRow = 0;
+};
+
+// Writes a map file one row at a time. Rows are gathered into bands of 64
+// and each band goes out as a row of tiles, so memory stays at one band
+// however large the map is. The header, with the row count, is written by
+// close().
+class MapFileWriter {
+public:
+    MapFileWriter() = default;
+    ~MapFileWriter();
+
+    MapFileWriter(const MapFileWriter&) = delete;
+    MapFileWriter& operator=(const MapFileWriter&) = delete;
+
+    bool create(const std::string& path, int cols, int layers, std::string& error);
+
+    // The row being written for 'layer': bit (col % 64) of word (col / 64);
+    // all clear at the start of each row
+    uint64_t* row(int layer) { return current.data() + (size_t)layer * wordsPerRow; }
+    // Hands over the current row and starts the next one
+    bool nextRow();
+    // Writes the last band and the header; false on an I/O error
+    bool close();
+
+    int getRows() const { return rows; }
+
+private:
+    bool writeBand();
+
+    std::FILE* file = nullptr;
+    int cols = 0, layers = 0;
+    int wordsPerRow = 0;
+    int rows = 0;
+    std::vector<uint64_t> current;      // one row per layer
+    std::vector<uint64_t> band;         // a row of tiles
+    bool failed = false;
+};
+
+// Writes a rows x cols map file whose fire layer has each cell burning with
+// probability 'percent' / 100, drawn from a counter-based generator keyed by
+// 'seed', so the same arguments always give the same file
+bool writeRandomMapFile(const std::string& path, int rows, int cols, int percent,
+                        uint64_t seed, std::string& error);
+
+inline uint64_t MapFile::word(int layer, int row, int tileCol) const {
+    size_t tile = (size_t)(row >> 6) * tilesPerRow + tileCol;
+    return tiles[(tile * layers + layer) * MAP_TILE + (row & 63)];
+}
+
+inline bool MapFile::get(int layer, int row, int col) const {
+    return (word(layer, row, col >> 6) >> (col & 63)) & 1u;
+}
+
+#endif // MAPFILE_H
@@ -0,0 +1,247 @@
+#include "MapRenderer.h"
+#include "Probe.h"
+
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// Map lines the layout leaves free: the title above, the cursor below
+const int RESERVED_LINES = 2;
+
+// Size of the terminal window stdout is on; false if it has none
+bool terminalSize(int& rows, int& cols) {
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) return false;
+    rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+    cols = info.srWindow.Right - info.srWindow.Left + 1;
+#else
+    winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_row == 0 || ws.ws_col == 0) return false;
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+#endif
+    return true;
+}
+
+void appendInt(std::string& out, int value) {
+    char digits[12];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr);
+}
+
+} // namespace
+
+MapRenderer::MapRenderer(int rows, int cols, double fps, const std::string& priority)
+    : rows(rows), cols(cols)
+{
+    interval = fps > 0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>(1.0 / fps))
+                       : std::chrono::steady_clock::duration::zero();
+    std::fill(rank, rank + 256, (int)priority.size());
+    for (size_t i = priority.size(); i-- > 0; ) rank[(uint8_t)priority[i]] = (int)i;
+    rank[0] = 256;      // block not filled yet
+
+#ifdef _WIN32
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+    tty = GetConsoleMode(out, &mode) && SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#else
+    tty = isatty(STDOUT_FILENO);
+#endif
+    if (!tty) {
+        // Logs and pipes: $COLUMNS x $LINES, or 80 x 50
+        const char* columns = std::getenv("COLUMNS");
+        const char* lines = std::getenv("LINES");
+        termCols = columns && std::atoi(columns) > 0 ? std::atoi(columns) : 80;
+        termRows = lines && std::atoi(lines) > 0 ? std::atoi(lines) : 50;
+        chooseLayout();
+    }
+}
+
+void MapRenderer::chooseLayout() {
+    int lines = std::max(1, termRows - RESERVED_LINES);
+    int width = std::max(1, termCols);
+    blockRows = blockCols = 1;
+    if (2 * rows + 1 <= lines && 4 * cols + 1 <= width) {
+        layout = Layout::Bordered;
+        screenRows = rows;
+        screenCols = cols;
+        fullBytes = (size_t)(2 * rows + 1) * (4 * cols + 2) + width + 64;
+        frame.reserve(fullBytes);
+        return;
+    }
+    if (rows <= lines && cols <= width) {
+        layout = Layout::Compact;
+    } else {
+        layout = Layout::Overview;
+        blockRows = (rows + lines - 1) / lines;
+        blockCols = (cols + width - 1) / width;
+    }
+    screenRows = (rows + blockRows - 1) / blockRows;
+    screenCols = (cols + blockCols - 1) / blockCols;
+    fullBytes = (size_t)screenRows * (screenCols + 1) + width + 64;
+    frame.reserve(fullBytes);
+}
+
+bool MapRenderer::draw(const std::string& title, const Glyph& glyph, bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && drawn && now - lastFrame < interval) return false;
+    lastFrame = now;
+    drawn = true;
+    PROBE_SCOPE("render.draw");
+
+    // Follow the window size; a new one needs a new layout and a repaint
+    int tr, tc;
+    if (tty && terminalSize(tr, tc) && (tr != termRows || tc != termCols)) {
+        termRows = tr;
+        termCols = tc;
+        chooseLayout();
+        repaint = true;
+    } else if (tty && termRows == 0) {
+        termRows = 24;
+        termCols = 80;
+        chooseLayout();
+    }
+
+    collect(glyph);
+    std::string fullTitle = title;
+    if (layout == Layout::Overview) {
+        fullTitle += " (1 char = " + std::to_string(blockRows) + "x" + std::to_string(blockCols) + " cells)";
+    }
+    if (tty && (int)fullTitle.size() > termCols) fullTitle.resize(termCols);
+
+    frame.clear();
+    if (!tty || repaint || shown.size() != next.size()) {
+        buildFull(fullTitle);
+    } else {
+        buildDiff(fullTitle);
+    }
+    shown.swap(next);
+    lastTitle = fullTitle;
+    repaint = false;
+    flush();
+    return true;
+}
+
+// Glyphs of every character of the map area into 'next'
+void MapRenderer::collect(const Glyph& glyph) {
+    next.assign((size_t)screenRows * screenCols, 0);
+    for (int r = 0; r < rows; r++) {
+        char* line = next.data() + (size_t)(r / blockRows) * screenCols;
+        for (int c = 0; c < cols; c++) {
+            char g = glyph(r, c);
+            char& slot = line[c / blockCols];
+            if (rank[(uint8_t)g] < rank[(uint8_t)slot]) slot = g;
+        }
+    }
+}
+
+void MapRenderer::buildFull(const std::string& title) {
+    if (tty) frame += "\x1b[?25l\x1b[H\x1b[2J";
+    frame += title;
+    frame += '\n';
+    if (layout == Layout::Bordered) {
+        std::string separator = "+";
+        for (int c = 0; c < cols; c++) separator += "---+";
+        separator += '\n';
+        for (int r = 0; r < rows; r++) {
+            frame += separator;
+            for (int c = 0; c < cols; c++) {
+                frame += "| ";
+                frame += next[(size_t)r * cols + c];
+                frame += ' ';
+            }
+            frame += "|\n";
+        }
+        frame += separator;
+        cursorLine = 2 * rows + 3;
+    } else {
+        for (int r = 0; r < screenRows; r++) {
+            frame.append(next.data() + (size_t)r * screenCols, screenCols);
+            frame += '\n';
+        }
+        cursorLine = screenRows + 2;
+    }
+    cursorColumn = 1;
+    if (tty) frame += "\x1b[?25h";
+}
+
+void MapRenderer::buildDiff(const std::string& title) {
+    size_t changed = 0;
+    for (size_t i = 0; i < next.size(); i++) changed += next[i] != shown[i];
+
+    // Past a point a cursor move per cell costs more than the whole frame
+    if (changed * 8 > fullBytes) {
+        buildFull(title);
+        return;
+    }
+    int parkLine = cursorLine;
+    if (changed == 0 && title == lastTitle) return;
+    frame += "\x1b[?25l";
+    if (title != lastTitle) {
+        moveTo(1, 1);
+        frame += title;
+        frame += "\x1b[K";
+        cursorColumn = 1 + (int)title.size();
+    }
+    for (size_t i = 0; i < next.size(); i++) {
+        if (next[i] == shown[i]) continue;
+        int r = (int)(i / screenCols), c = (int)(i % screenCols);
+        if (layout == Layout::Bordered) {
+            moveTo(3 + 2 * r, 4 * c + 3);
+        } else {
+            moveTo(2 + r, c + 1);
+        }
+        frame += next[i];
+        cursorColumn++;
+    }
+    moveTo(parkLine, 1);
+    frame += "\x1b[?25h";
+}
+
+void MapRenderer::moveTo(int line, int column) {
+    if (line == cursorLine && column == cursorColumn) return;
+    frame += "\x1b[";
+    appendInt(frame, line);
+    frame += ';';
+    appendInt(frame, column);
+    frame += 'H';
+    cursorLine = line;
+    cursorColumn = column;
+}
+
+void MapRenderer::flush() {
+    if (frame.empty()) return;
+    std::cout.flush();      // anything printed before the frame goes first
+    const char* p = frame.data();
+    size_t left = frame.size();
+    while (left > 0) {
+#ifdef _WIN32
+        DWORD n = 0;
+        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), p, (DWORD)left, &n, nullptr)) return;
+#else
+        ssize_t n = write(STDOUT_FILENO, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+#endif
+        p += n;
+        left -= (size_t)n;
+        bytes += (uint64_t)n;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef MAPRENDERER_H
+#define MAPRENDERER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+// Draws a map on the terminal without repainting it every time. The last
+// frame is kept and the next one only rewrites the cells that changed,
+// placed with ANSI cursor moves; the whole update is built in one reused
+// buffer and goes out in a single write. Frames closer together than the
+// target rate are skipped.
+//
+// The layout follows the terminal size: the bordered grid when it fits, one
+// character per cell when that fits, otherwise an overview where each
+// character stands for a block of cells. A block shows its highest-ranked
+// glyph (see 'priority'). When stdout is not a terminal every frame is
+// written out in full, without escape codes.
+class MapRenderer {
+public:
+    // Character of map cell (row, col)
+    using Glyph = std::function<char(int row, int col)>;
+
+    // 'fps' caps the frame rate, 0 = no cap. 'priority' ranks the glyphs
+    // for the overview, highest first; glyphs not in it rank lowest.
+    MapRenderer(int rows, int cols, double fps, const std::string& priority);
+
+    // Draws a frame under the 'title' line unless the previous one was too
+    // recent ('force' draws regardless). Returns true if it drew.
+    bool draw(const std::string& title, const Glyph& glyph, bool force = false);
+
+    // Something else wrote to the screen: repaint everything next time
+    void invalidate() { repaint = true; }
+
+    // Bytes written so far
+    uint64_t getBytes() const { return bytes; }
+
+private:
+    enum class Layout { Bordered, Compact, Overview };
+
+    void chooseLayout();
+    void collect(const Glyph& glyph);
+    void buildFull(const std::string& title);
+    void buildDiff(const std::string& title);
+    void moveTo(int line, int column);
+    void flush();
+
+    int rows, cols;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point lastFrame;
+    bool drawn = false;
+    int rank[256];
+
+    bool tty;
+    bool repaint = true;
+    int termRows = 0, termCols = 0;
+    Layout layout = Layout::Bordered;
+    int blockRows = 1, blockCols = 1;   // cells per character (Overview)
+    int screenRows = 0, screenCols = 0; // characters in the map area
+
+    std::vector<char> shown;    // what is on screen, per map character
+    std::vector<char> next;
+    std::string lastTitle;
+    std::string frame;          // reused output buffer
+    size_t fullBytes = 0;       // size of a full frame
+    int cursorLine = 0, cursorColumn = 0;
+    uint64_t bytes = 0;
+};
+
+#endif // MAPRENDERER_H
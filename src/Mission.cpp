@@ -0,0 +1,244 @@
+#include "Mission.h"
+#include "Probe.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+// Adds the time of one planning call to the mission stats on scope exit
+class PlanTimer {
+public:
+    explicit PlanTimer(Mission::Stats& stats)
+        : stats(stats), start(std::chrono::steady_clock::now()) {}
+    ~PlanTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stats.decisions++;
+        stats.planNanos += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+private:
+    Mission::Stats& stats;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace
+
+Mission::Mission(GridMap& map, const MissionConfig& config)
+    : map(map), config(config), planner(makePlanner(config.planner)),
+      sensor(config.sensor, config.perceptionRange)
+{
+    if (!planner) planner = makePlanner("astar");
+}
+
+// Marks everything the sensor sees from the drone's cell as discovered and
+// reports fire cells seen for the first time. Returns how many cells were
+// new. Each row of the footprint is a run of columns, applied a word at a
+// time: the new cells are the run less what was already discovered, the
+// new fires those of them that burn.
+int Mission::discoverCells()
+{
+    PROBE_SCOPE("mission.discover");
+    int rows = map.getRows();
+    int cols = map.getCols();
+    int range = sensor.getRange();
+    bool occluded = sensor.occludes();
+    int before = discovered.getUndiscovered();
+    newFires.clear();
+    if (occluded) sensor.trace(map, droneRow, droneCol);
+
+    for (int dr = -range; dr <= range; dr++) {
+        int rr = droneRow + dr;
+        if (rr < 0 || rr >= rows) continue;
+        int c0 = std::max(droneCol - sensor.span(dr), 0);
+        int c1 = std::min(droneCol + sensor.span(dr), cols - 1);
+        int w0 = c0 >> 6, w1 = c1 >> 6;
+        const uint64_t* fire = map.fireRow(rr);
+        for (int w = w0; w <= w1; w++) {
+            uint64_t seen = bitRange(w == w0 ? c0 & 63 : 0, w == w1 ? c1 & 63 : 63);
+            if (occluded) {
+                swept.mark(rr, w, seen);
+                seen &= sensor.visibleWord(dr, w);
+            }
+            uint64_t fresh = discovered.mark(rr, w, seen);
+            if (sweeping) {
+                for (uint64_t bits = fresh; bits; bits &= bits - 1) {
+                    reach.markDiscovered(rr, w * 64 + __builtin_ctzll(bits));
+                }
+            }
+            for (uint64_t bits = fresh & fire[w]; bits; bits &= bits - 1) {
+                int cc = w * 64 + __builtin_ctzll(bits);
+                if (onFireSeen) onFireSeen(rr, cc);
+                if (onFiresSeen) newFires.emplace_back(rr, cc);
+            }
+        }
+    }
+    if (!newFires.empty()) onFiresSeen(newFires);
+    if (onScan) {
+        onScan(std::max(droneRow - range, 0), std::max(droneCol - range, 0),
+               std::min(droneRow + range, rows - 1), std::min(droneCol + range, cols - 1));
+    }
+    return before - discovered.getUndiscovered();
+}
+
+int Mission::moveTo(int r, int c)
+{
+    droneRow = r;
+    droneCol = c;
+    int found = discoverCells();
+
+    stats.steps++;
+    if (config.spreadEvery > 0 && config.spreadChance > 0 && stats.steps % config.spreadEvery == 0) {
+        auto start = std::chrono::steady_clock::now();
+        map.spreadFires(config.spreadChance);
+        planner->cellsBlocked(map.getLastIgnited());
+        if (repairing) {
+            repair.cellsBlocked(map.getLastIgnited());
+        }
+        if (sweeping) {
+            reach.cellsBlocked(map.getLastIgnited());
+        }
+        if (onSpread) onSpread(map.getLastIgnited());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stats.spreads++;
+        stats.spreadNanos += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+    if (onMove) onMove();
+    return found;
+}
+
+// True (and the mission is over) once no undiscovered cell is reachable
+bool Mission::lost()
+{
+    PlanTimer timer(stats);
+    if (!reach.reachableUndiscovered(droneRow, droneCol)) {
+        signalLost = true;
+    }
+    return signalLost;
+}
+
+// Fly to (i, j) unless it has already been seen
+void Mission::visitCell(int i, int j)
+{
+    if (discovered.isDiscovered(i, j)) return;
+
+    {
+        PlanTimer timer(stats);
+        // Targets in another component (or on fire) would only cost the
+        // planner a flood of the drone's whole component to find nothing
+        if (reach.reachable(droneRow, droneCol, i, j)) {
+            planner->findPath(map, droneRow, droneCol, i, j, path);
+        } else {
+            path.clear();
+        }
+    }
+    if (path.empty()) {
+        // If no path, check if there is any undiscovered cell we can still reach
+        lost();
+        return;
+    }
+    repairing = false;
+    for (size_t idx = 1; idx < path.size() && !signalLost; idx++) {
+        auto [r, c] = path[idx];
+
+        // If the next cell is on fire, D* Lite repairs the route; it is fed
+        // the cells each spreadFires ignites from then on
+        if (map.getCell(r, c) == 'X') {
+            {
+                PlanTimer timer(stats);
+                if (!repairing) {
+                    repair.reset(map, droneRow, droneCol, i, j);
+                    repairing = true;
+                } else {
+                    repair.moveStart(droneRow, droneCol);
+                }
+                repair.computePath(path);
+            }
+            if (path.empty()) {
+                lost();
+                break;
+            }
+            idx = 0;
+            continue;
+        }
+        moveTo(r, c);
+    }
+    repairing = false;
+}
+
+// Scan the entire map row by row, alternating direction
+void Mission::runSweep()
+{
+    int rows = map.getRows();
+    int cols = map.getCols();
+    for (int i = 0; i < rows && !signalLost; i++) {
+        if (i % 2 == 0) {
+            // left->right
+            for (int j = 0; j < cols && !signalLost; j++) {
+                visitCell(i, j);
+            }
+        } else {
+            // right->left
+            for (int j = cols - 1; j >= 0 && !signalLost; j--) {
+                visitCell(i, j);
+            }
+        }
+    }
+}
+
+// Repeatedly fly towards the frontier cell chosen by one BFS. The route is
+// dropped as soon as a move reveals something (the best target may have
+// changed) or fire blocks it; long flights back across explored ground
+// reveal nothing and so cost a single search.
+void Mission::runFrontier()
+{
+    FrontierGoal goal = config.mode == ExploreMode::InfoGain ? FrontierGoal::InfoGain
+                                                             : FrontierGoal::Nearest;
+    const DiscoveredLayer& unseen = sensor.occludes() ? swept : discovered;
+    while (true) {
+        bool found;
+        {
+            PlanTimer timer(stats);
+            found = findFrontierPath(map, unseen, frontierWs, droneRow, droneCol, sensor, goal, path);
+        }
+        if (!found) {
+            // Nothing reachable left: lost if anything is still out of
+            // reach (not merely hidden by fire)
+            signalLost = unseen.getUndiscovered() > 0;
+            return;
+        }
+        for (size_t idx = 1; idx < path.size(); idx++) {
+            auto [r, c] = path[idx];
+            if (map.getCell(r, c) == 'X') break;
+            if (moveTo(r, c) > 0) break;
+        }
+    }
+}
+
+bool Mission::run(int startRow, int startCol)
+{
+    int rows = map.getRows();
+    int cols = map.getCols();
+    discovered.reset(rows, cols);
+    if (sensor.occludes()) {
+        swept.reset(rows, cols);
+    }
+    stats = Stats();
+    // The map may have been refilled since the last run (see runBatch)
+    planner->reset();
+    droneRow = startRow;
+    droneCol = startCol;
+    signalLost = false;
+    repairing = false;
+    sweeping = config.mode == ExploreMode::Sweep;
+    if (sweeping) {
+        reach.build(map);
+    }
+
+    discoverCells();
+    if (sweeping) {
+        runSweep();
+    } else {
+        runFrontier();
+    }
+    return !signalLost;
+}
@@ -0,0 +1,110 @@
+#ifndef MISSION_H
+#define MISSION_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+#include "GridMap.h"
+#include "Pathfinding.h"
+#include "DStarLite.h"
+#include "Connectivity.h"
+#include "Coverage.h"
+#include "Sensor.h"
+
+// How the drone picks where to fly next
+//  Sweep:    visit every undiscovered cell in boustrophedon row order, one
+//            planner query per cell (the original behaviour).
+//  Frontier: one BFS per decision to the nearest cell that reveals anything.
+//  InfoGain: like Frontier, but prefers cells that reveal the most per move.
+enum class ExploreMode { Sweep, Frontier, InfoGain };
+
+struct MissionConfig {
+    ExploreMode mode = ExploreMode::Frontier;
+    std::string planner = "astar";  // Sweep legs: "bfs", "astar", "jps" or "hpa"
+    SensorShape sensor = SensorShape::Square;
+    int perceptionRange = 2;
+    double spreadChance = 0.02;
+    int spreadEvery = 5;            // moves between spreadFires calls, 0 = never
+};
+
+// The drone's exploration loop, without any I/O: it moves over 'map',
+// keeps the discovered layer up to date and reports through the callbacks,
+// so the client, benchmarks and tools can all drive the same mission.
+class Mission {
+public:
+    struct Stats {
+        uint64_t steps = 0;         // moves flown
+        uint64_t decisions = 0;     // planning calls (targets, frontier searches, replans)
+        uint64_t planNanos = 0;     // time spent in them
+        uint64_t spreads = 0;       // spreadFires calls
+        uint64_t spreadNanos = 0;   // time spent in them, index updates included
+    };
+
+    Mission(GridMap& map, const MissionConfig& config);
+
+    // Called once for each fire cell, the first time the drone sees it
+    std::function<void(int row, int col)> onFireSeen;
+    // Called once per perception update with all the fire cells it saw for
+    // the first time (never with an empty list), so they can be reported
+    // together
+    std::function<void(const std::vector<std::pair<int,int>>& fires)> onFiresSeen;
+    // Called after every perception update with the square around the
+    // sensor footprint, clipped to the map (inclusive bounds); with a circle
+    // or line of sight not every cell in it was seen
+    std::function<void(int top, int left, int bottom, int right)> onScan;
+    // Called after every move
+    std::function<void()> onMove;
+    // Called after each spread step with the cells it ignited (see
+    // GridMap::getLastIgnited)
+    std::function<void(const std::vector<int>& ignited)> onSpread;
+
+    // Flies from (startRow, startCol) until nothing reachable is left to
+    // discover. Returns false if undiscovered cells remain that the drone
+    // can no longer reach ("signal lost"). Each run starts afresh, stats
+    // included, and reuses the buffers of the last one.
+    bool run(int startRow, int startCol);
+
+    int getDroneRow() const { return droneRow; }
+    int getDroneCol() const { return droneCol; }
+    const DiscoveredLayer& getDiscovered() const { return discovered; }
+    int getUndiscovered() const { return discovered.getUndiscovered(); }
+    const Stats& getStats() const { return stats; }
+    const PathPlanner& getPlanner() const { return *planner; }
+    const DStarLite& getRepair() const { return repair; }
+    const PathWorkspace& getFrontierWorkspace() const { return frontierWs; }
+    const ConnectivityIndex& getReach() const { return reach; }
+    const SensorFootprint& getSensor() const { return sensor; }
+
+private:
+    int discoverCells();
+    int moveTo(int r, int c);
+    bool lost();
+    void visitCell(int i, int j);
+    void runSweep();
+    void runFrontier();
+
+    GridMap& map;
+    MissionConfig config;
+    std::unique_ptr<PathPlanner> planner;
+    DStarLite repair;       // takes over a sweep leg once fire cuts it
+    bool repairing = false;
+    bool sweeping = false;
+    PathWorkspace frontierWs;
+    ConnectivityIndex reach;    // Sweep: what the drone can still get to
+    SensorFootprint sensor;
+    DiscoveredLayer discovered;
+    // Line of sight: the cells that have been within range, seen or hidden.
+    // Frontier search targets the rest, so the drone does not keep flying
+    // to places whose unseen cells stay behind fire.
+    DiscoveredLayer swept;
+    std::vector<std::pair<int,int>> path;
+    std::vector<std::pair<int,int>> newFires;  // scratch for onFiresSeen
+    int droneRow = 0, droneCol = 0;
+    bool signalLost = false;
+    Stats stats;
+};
+
+#endif // MISSION_H
@@ -0,0 +1,427 @@
+#include "MissionLog.h"
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = {'D', 'R', 'O', 'N', 'E', 'L', 'O', 'G'};
+
+// The writer wakes early once this much is waiting, and otherwise every
+// FLUSH_INTERVAL, so a crash loses at most that much of the mission
+const size_t FLUSH_BYTES = 256 << 10;
+const auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+
+// Records above this size are treated as a torn or corrupt log
+const uint64_t MAX_RECORD = 1ULL << 32;
+// Highest drone id a replay keeps a position for
+const uint64_t MAX_DRONE = 1 << 16;
+
+// Each thread encodes its payloads here before taking the lock
+thread_local std::string scratch;
+
+} // namespace
+
+MissionLog::~MissionLog() {
+    close();
+}
+
+bool MissionLog::open(const std::string& path, int rows, int cols, uint64_t seed,
+                      std::string& error, size_t capacity) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    this->rows = rows;
+    this->cols = cols;
+    this->capacity = std::max(capacity, FLUSH_BYTES);
+    stats = Stats();
+    stopping = false;
+
+    char header[MISSION_LOG_HEADER] = {};
+    uint32_t version = MISSION_LOG_VERSION, r = (uint32_t)rows, c = (uint32_t)cols;
+    memcpy(header, MAGIC, 8);
+    memcpy(header + 8, &version, 4);
+    memcpy(header + 12, &r, 4);
+    memcpy(header + 16, &c, 4);
+    memcpy(header + 24, &seed, 8);
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        fclose(file);
+        file = nullptr;
+        error = "cannot write " + path;
+        return false;
+    }
+    stats.bytes = sizeof(header);
+    writer = std::thread(&MissionLog::writerLoop, this);
+    return true;
+}
+
+void MissionLog::close() {
+    if (!file) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    if (fclose(file) != 0) stats.failed = true;
+    file = nullptr;
+}
+
+void MissionLog::fires(const GridMap& map) {
+    if (!file) return;
+    scratch.clear();
+    size_t rowBytes = (size_t)map.getWordsPerRow() * sizeof(uint64_t);
+    for (int r = 0; r < rows; r++) {
+        scratch.append((const char*)map.fireRow(r), rowBytes);
+    }
+    append(LogEvent::Fires, scratch);
+}
+
+void MissionLog::move(int drone, int row, int col) {
+    if (!file) return;
+    scratch.clear();
+    putVarint(scratch, (uint64_t)drone);
+    putVarint(scratch, (uint64_t)row);
+    putVarint(scratch, (uint64_t)col);
+    append(LogEvent::Move, scratch);
+}
+
+void MissionLog::scan(int drone, int top, int left, int bottom, int right) {
+    if (!file) return;
+    scratch.clear();
+    putVarint(scratch, (uint64_t)drone);
+    putVarint(scratch, (uint64_t)top);
+    putVarint(scratch, (uint64_t)left);
+    putVarint(scratch, (uint64_t)bottom);
+    putVarint(scratch, (uint64_t)right);
+    append(LogEvent::Scan, scratch);
+}
+
+void MissionLog::cells(int drone, const std::vector<uint64_t>& cells) {
+    if (!file || cells.empty()) return;
+    scratch.clear();
+    putVarint(scratch, (uint64_t)drone);
+    putVarint(scratch, cells.size());
+    uint64_t last = 0;
+    for (uint64_t cell : cells) {
+        putVarint(scratch, zigzag((int64_t)(cell - last)));
+        last = cell;
+    }
+    append(LogEvent::Cells, scratch);
+}
+
+void MissionLog::spread(const std::vector<int>& ignited) {
+    if (!file || ignited.empty()) return;
+    scratch.clear();
+    putVarint(scratch, ignited.size());
+    int last = 0;
+    for (int cell : ignited) {
+        putVarint(scratch, (uint64_t)(cell - last));
+        last = cell;
+    }
+    append(LogEvent::Spread, scratch);
+}
+
+void MissionLog::message(int drone, const char* data, size_t len) {
+    if (!file) return;
+    scratch.clear();
+    putVarint(scratch, (uint64_t)drone);
+    scratch.append(data, len);
+    append(LogEvent::Message, scratch);
+}
+
+void MissionLog::append(LogEvent type, const std::string& payload) {
+    std::unique_lock<std::mutex> guard(lock);
+    // Back-pressure: a caller only waits when the disk is this far behind
+    if (pending.size() >= capacity && !stats.failed) {
+        stats.stalls++;
+        drained.wait(guard, [&] { return pending.size() < capacity || stats.failed; });
+    }
+    if (stats.failed) return;
+    size_t before = pending.size();
+    putVarint(pending, payload.size() + 1);
+    pending += (char)type;
+    pending += payload;
+    stats.events++;
+    stats.maxPending = std::max<uint64_t>(stats.maxPending, pending.size());
+    if (before < FLUSH_BYTES && pending.size() >= FLUSH_BYTES) wake.notify_one();
+}
+
+void MissionLog::writerLoop() {
+    std::string out;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait_for(guard, FLUSH_INTERVAL, [&] { return stopping || pending.size() >= FLUSH_BYTES; });
+        if (pending.empty()) {
+            if (stopping) break;
+            continue;
+        }
+        out.swap(pending);
+        drained.notify_all();
+        guard.unlock();
+        bool ok = fwrite(out.data(), 1, out.size(), file) == out.size() && fflush(file) == 0;
+        guard.lock();
+        stats.writes++;
+        if (ok) {
+            stats.bytes += out.size();
+        } else {
+            stats.failed = true;
+            pending.clear();
+            drained.notify_all();
+        }
+        out.clear();
+    }
+}
+
+void ReplayState::reset(int r, int c) {
+    rows = r;
+    cols = c;
+    wordsPerRow = (c + 63) / 64;
+    size_t words = (size_t)rows * wordsPerRow;
+    fire.assign(words, 0);
+    seen.assign(words, 0);
+    found.assign(words, 0);
+    drones.clear();
+    events = moves = spreads = messages = messageBytes = 0;
+}
+
+uint64_t ReplayState::count(const std::vector<uint64_t>& layer) const {
+    uint64_t total = 0;
+    for (uint64_t w : layer) total += (uint64_t)__builtin_popcountll(w);
+    return total;
+}
+
+bool ReplayState::apply(LogEvent type, const char* payload, size_t len) {
+    if (!applyRecord(type, payload, len)) return false;
+    events++;
+    return true;
+}
+
+bool ReplayState::applyRecord(LogEvent type, const char* payload, size_t len) {
+    const char* p = payload;
+    const char* end = payload + len;
+    auto inside = [&](uint64_t r, uint64_t c) { return r < (uint64_t)rows && c < (uint64_t)cols; };
+    switch (type) {
+    case LogEvent::Fires: {
+        if (len != fire.size() * sizeof(uint64_t)) return false;
+        memcpy(fire.data(), payload, len);
+        return true;
+    }
+    case LogEvent::Move: {
+        uint64_t drone, r, c;
+        if (!getVarint(p, end, drone) || !getVarint(p, end, r) || !getVarint(p, end, c)) return false;
+        if (drone >= MAX_DRONE || !inside(r, c)) return false;
+        if (drone >= drones.size()) drones.resize(drone + 1, {-1, -1});
+        drones[drone] = {(int)r, (int)c};
+        moves++;
+        return true;
+    }
+    case LogEvent::Scan: {
+        uint64_t drone, top, left, bottom, right;
+        if (!getVarint(p, end, drone) || !getVarint(p, end, top) || !getVarint(p, end, left) ||
+            !getVarint(p, end, bottom) || !getVarint(p, end, right)) {
+            return false;
+        }
+        if (!inside(bottom, right)) return false;
+        // Cells seen for the first time count as found if they burn now
+        for (uint64_t r = top; r <= bottom; r++) {
+            for (uint64_t c = left; c <= right; c++) {
+                if (get(seen, (int)r, (int)c)) continue;
+                set(seen, (int)r, (int)c);
+                if (get(fire, (int)r, (int)c)) set(found, (int)r, (int)c);
+            }
+        }
+        return true;
+    }
+    case LogEvent::Cells: {
+        uint64_t drone, n, delta;
+        if (!getVarint(p, end, drone) || !getVarint(p, end, n)) return false;
+        uint64_t cell = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            if (!getVarint(p, end, delta)) return false;
+            cell += (uint64_t)unzigzag(delta);
+            uint64_t index = cell >> 1;
+            if (index >= (uint64_t)rows * cols) return false;
+            int r = (int)(index / cols), c = (int)(index % cols);
+            set(seen, r, c);
+            if (cell & 1) set(found, r, c);
+        }
+        return true;
+    }
+    case LogEvent::Spread: {
+        uint64_t n, delta;
+        if (!getVarint(p, end, n)) return false;
+        uint64_t cell = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            if (!getVarint(p, end, delta)) return false;
+            cell += delta;
+            if (cell >= (uint64_t)rows * cols) return false;
+            set(fire, (int)(cell / cols), (int)(cell % cols));
+        }
+        spreads++;
+        return true;
+    }
+    case LogEvent::Message: {
+        uint64_t drone;
+        if (!getVarint(p, end, drone)) return false;
+        messages++;
+        messageBytes += (uint64_t)(end - p);
+        return true;
+    }
+    }
+    // Types from a later version carry nothing this one tracks
+    return true;
+}
+
+MissionReplay::~MissionReplay() {
+    close();
+}
+
+void MissionReplay::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+#else
+    munmap((void*)data, length);
+#endif
+    data = nullptr;
+    length = end = 0;
+    snapshots.clear();
+}
+
+bool MissionReplay::record(size_t offset, LogEvent& type, const char*& payload, size_t& len, size_t& next) const {
+    const char* p = data + offset;
+    const char* stop = data + length;
+    uint64_t size;
+    if (!getVarint(p, stop, size) || size == 0 || size > MAX_RECORD || size > (uint64_t)(stop - p)) return false;
+    type = (LogEvent)(uint8_t)*p;
+    payload = p + 1;
+    len = (size_t)size - 1;
+    next = (size_t)(p + size - data);
+    return true;
+}
+
+bool MissionReplay::open(const std::string& path, std::string& error) {
+    close();
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(fh, &size);
+    length = (size_t)size.QuadPart;
+    HANDLE mh = length >= MISSION_LOG_HEADER ? CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    void* view = mh ? MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mh) CloseHandle(mh);
+        CloseHandle(fh);
+        error = path + " is not a mission log";
+        return false;
+    }
+    fileHandle = fh;
+    mappingHandle = mh;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < MISSION_LOG_HEADER) {
+        ::close(fd);
+        error = path + " is not a mission log";
+        return false;
+    }
+    length = (size_t)st.st_size;
+    void* view = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    // Indexing reads the log front to back
+    madvise(view, length, MADV_SEQUENTIAL);
+#endif
+    data = (const char*)view;
+
+    uint32_t version, r, c;
+    memcpy(&version, data + 8, 4);
+    memcpy(&r, data + 12, 4);
+    memcpy(&c, data + 16, 4);
+    memcpy(&seed, data + 24, 8);
+    if (memcmp(data, MAGIC, 8) != 0 || r == 0 || c == 0 || r > (1u << 30) || c > (1u << 30)) {
+        close();
+        error = path + " is not a mission log";
+        return false;
+    }
+    if (version != MISSION_LOG_VERSION) {
+        close();
+        error = path + " has an unsupported log version";
+        return false;
+    }
+    rows = (int)r;
+    cols = (int)c;
+
+    // One pass over the records. A snapshot is taken once the records since
+    // the last one take up as many bytes as a snapshot does, so snapshots
+    // never need more memory than the log itself, and a seek replays at
+    // most a snapshot's worth of log.
+    ReplayState state;
+    state.reset(rows, cols);
+    snapshots.clear();
+    snapshots.push_back({0, MISSION_LOG_HEADER, state});
+    typeCounts.assign(256, 0);
+    size_t offset = MISSION_LOG_HEADER;
+    size_t spacing = std::max<size_t>(state.bytes(), 64 << 10);
+    LogEvent type;
+    const char* payload;
+    size_t len, next;
+    while (record(offset, type, payload, len, next)) {
+        if (!state.apply(type, payload, len)) break;
+        typeCounts[(uint8_t)type]++;
+        offset = next;
+        if (offset - snapshots.back().offset >= spacing) {
+            snapshots.push_back({state.events, offset, state});
+        }
+    }
+    // A torn last record, or damage: the log ends at the last good one
+    end = offset;
+    events = state.events;
+    return true;
+}
+
+void MissionReplay::seek(uint64_t event, ReplayState& state) const {
+    event = std::min(event, events);
+    // The last snapshot at or before 'event'
+    auto it = std::upper_bound(snapshots.begin(), snapshots.end(), event,
+                               [](uint64_t e, const Snapshot& s) { return e < s.event; });
+    const Snapshot& from = *(it - 1);
+    state = from.state;
+    size_t offset = from.offset;
+    LogEvent type;
+    const char* payload;
+    size_t len, next;
+    while (state.events < event && offset < end && record(offset, type, payload, len, next)) {
+        state.apply(type, payload, len);
+        offset = next;
+    }
+}
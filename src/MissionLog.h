@@ -0,0 +1,185 @@
+#ifndef MISSIONLOG_H
+#define MISSIONLOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GridMap.h"
+
+// Mission log: every event of a mission, appended to a compact binary file
+// so a long mission can be looked at afterwards without flying it again.
+//
+//   header, MISSION_LOG_HEADER bytes: "DRONELOG", u32 version, u32 rows,
+//          u32 cols, u32 zero, u64 seed (little-endian)
+//   records: varint length | u8 type | payload (length - 1 bytes), framed
+//          like the binary telemetry so unknown types can be skipped
+//
+//   Fires:   the whole fire layer, rows * words-per-row u64 words as in
+//            GridMap::fireRow(); the drone logs it before it starts
+//   Move:    varint drone, varint row, varint col
+//   Scan:    varint drone, varint top, left, bottom, right: the drone
+//            looked at that square (inclusive bounds)
+//   Cells:   varint drone, varint count, then count zigzag deltas of
+//            (row * cols + col) * 2 + fire: cells a drone reported seen,
+//            as the station heard them, or cells a drone with a round or
+//            line-of-sight sensor saw for the first time
+//   Spread:  varint count, then count deltas of row * cols + col, in
+//            row-major order: the cells one spreadFires step ignited
+//   Message: varint drone, the bytes of one message sent or received
+//
+// A drone id is the drone's own id (its index in a fleet) in a drone's log
+// and the connection number in the station's.
+const int MISSION_LOG_VERSION = 1;
+const size_t MISSION_LOG_HEADER = 32;
+
+enum class LogEvent : uint8_t { Fires = 1, Move = 2, Scan = 3, Cells = 4, Spread = 5, Message = 6 };
+
+// Appends events from any thread. Each event is encoded by the caller into
+// a shared buffer under a short lock; a writer thread swaps the buffer out
+// and writes it to the file, so the callers never wait on the disk unless
+// 'capacity' bytes are already waiting.
+class MissionLog {
+public:
+    struct Stats {
+        uint64_t events = 0;
+        uint64_t bytes = 0;         // written, header included
+        uint64_t writes = 0;        // fwrite calls of the writer thread
+        uint64_t maxPending = 0;    // most bytes waiting for the writer
+        uint64_t stalls = 0;        // appends that waited for the writer
+        bool failed = false;        // a write failed; later events were dropped
+    };
+
+    MissionLog() = default;
+    ~MissionLog();
+
+    MissionLog(const MissionLog&) = delete;
+    MissionLog& operator=(const MissionLog&) = delete;
+
+    // Creates 'path' and starts the writer thread. False, with 'error' set,
+    // if the file cannot be created.
+    bool open(const std::string& path, int rows, int cols, uint64_t seed,
+              std::string& error, size_t capacity = 64 << 20);
+    bool isOpen() const { return file != nullptr; }
+
+    void fires(const GridMap& map);
+    void move(int drone, int row, int col);
+    void scan(int drone, int top, int left, int bottom, int right);
+    // 'cells' holds (row * cols + col) * 2 + (on fire ? 1 : 0) per cell
+    void cells(int drone, const std::vector<uint64_t>& cells);
+    void spread(const std::vector<int>& ignited);
+    void message(int drone, const char* data, size_t len);
+
+    // Writes out everything appended and closes the file. Called by the
+    // destructor too.
+    void close();
+
+    // Valid after close()
+    const Stats& getStats() const { return stats; }
+
+private:
+    void append(LogEvent type, const std::string& payload);
+    void writerLoop();
+
+    FILE* file = nullptr;
+    int rows = 0, cols = 0;
+    size_t capacity = 0;
+
+    std::mutex lock;
+    std::condition_variable wake;       // the writer: data or close
+    std::condition_variable drained;    // the callers: room in 'pending'
+    std::string pending;                // encoded records not yet written
+    bool stopping = false;
+    std::thread writer;
+    Stats stats;
+};
+
+// The state of a mission after some number of events, rebuilt from a log
+struct ReplayState {
+    int rows = 0, cols = 0, wordsPerRow = 0;
+    std::vector<uint64_t> fire;     // burning cells (drone logs)
+    std::vector<uint64_t> seen;     // cells some drone has seen
+    std::vector<uint64_t> found;    // cells seen on fire
+    std::vector<std::pair<int,int>> drones;     // last position by drone id, -1 = none yet
+    uint64_t events = 0;
+    uint64_t moves = 0;
+    uint64_t spreads = 0;
+    uint64_t messages = 0;
+    uint64_t messageBytes = 0;
+
+    void reset(int rows, int cols);
+    // Applies one record; false if its payload is malformed
+    bool apply(LogEvent type, const char* payload, size_t len);
+
+    bool get(const std::vector<uint64_t>& layer, int r, int c) const {
+        return (layer[(size_t)r * wordsPerRow + (c >> 6)] >> (c & 63)) & 1u;
+    }
+    uint64_t count(const std::vector<uint64_t>& layer) const;
+    size_t bytes() const { return (fire.size() + seen.size() + found.size()) * sizeof(uint64_t); }
+
+private:
+    bool applyRecord(LogEvent type, const char* payload, size_t len);
+    void set(std::vector<uint64_t>& layer, int r, int c) {
+        layer[(size_t)r * wordsPerRow + (c >> 6)] |= 1ULL << (c & 63);
+    }
+};
+
+// A mission log mapped read-only, with snapshots of the state taken while
+// it is indexed, so any event can be reached by replaying from the nearest
+// snapshot before it: a binary search, then at most one snapshot interval
+// of records.
+class MissionReplay {
+public:
+    MissionReplay() = default;
+    ~MissionReplay();
+
+    MissionReplay(const MissionReplay&) = delete;
+    MissionReplay& operator=(const MissionReplay&) = delete;
+
+    // Maps 'path' and replays it once to count its events and take the
+    // snapshots. A log cut short (the writer was killed) is read up to its
+    // last whole record. False, with 'error' set, if it is not a log.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    uint64_t getSeed() const { return seed; }
+    uint64_t getEvents() const { return events; }
+    size_t getBytes() const { return end; }
+    size_t getSnapshots() const { return snapshots.size(); }
+    // Records of each type, indexed by LogEvent
+    const std::vector<uint64_t>& getTypeCounts() const { return typeCounts; }
+
+    // The state after the first 'event' events (all of them past the end)
+    void seek(uint64_t event, ReplayState& state) const;
+
+private:
+    struct Snapshot {
+        uint64_t event;     // events applied
+        size_t offset;      // of the next record
+        ReplayState state;
+    };
+
+    // Decodes the record at 'offset'; false at the end or on a torn record
+    bool record(size_t offset, LogEvent& type, const char*& payload, size_t& len, size_t& next) const;
+
+    const char* data = nullptr;
+    size_t length = 0;
+    size_t end = 0;         // just past the last whole record
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    int rows = 0, cols = 0;
+    uint64_t seed = 0;
+    uint64_t events = 0;
+    std::vector<uint64_t> typeCounts;
+    std::vector<Snapshot> snapshots;
+};
+
+#endif // MISSIONLOG_H
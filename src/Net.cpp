@@ -0,0 +1,292 @@
+#include "Net.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+bool setNonBlocking(NetSocket s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool wouldBlock() {
+#ifdef _WIN32
+    int err = WSAGetLastError();
+    return err == WSAEWOULDBLOCK || err == WSAETIMEDOUT;    // SO_RCVTIMEO ran out
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool interrupted() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEINTR;
+#else
+    return errno == EINTR;
+#endif
+}
+
+// How long a send waits for a full socket buffer to drain before giving up
+const int SEND_WAIT_MS = 5000;
+
+// Waits until 's' can take more data; false if it timed out or failed
+bool waitWritable(NetSocket s, int timeoutMs) {
+#ifdef _WIN32
+    WSAPOLLFD fd;
+    fd.fd = s;
+    fd.events = POLLWRNORM;
+    fd.revents = 0;
+    return WSAPoll(&fd, 1, timeoutMs) > 0;
+#else
+    pollfd fd;
+    fd.fd = s;
+    fd.events = POLLOUT;
+    fd.revents = 0;
+    int n;
+    do {
+        n = poll(&fd, 1, timeoutMs);
+    } while (n < 0 && errno == EINTR);
+    return n > 0;
+#endif
+}
+
+} // namespace
+
+bool netInit() {
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2,2), &wsaData) == 0;
+#else
+    return true;
+#endif
+}
+
+void netCleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void netClose(NetSocket s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+void netCloseGracefully(NetSocket s, int timeoutMs) {
+#ifdef _WIN32
+    shutdown(s, SD_SEND);
+#else
+    shutdown(s, SHUT_WR);
+#endif
+    netSetRecvTimeout(s, timeoutMs);
+    char buf[256];
+    while (netRecv(s, buf, sizeof(buf)) > 0) {}
+    netClose(s);
+}
+
+NetSocket netConnect(const char* host, int port) {
+    NetSocket s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == NET_INVALID) return NET_INVALID;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) <= 0 ||
+        connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        netClose(s);
+        return NET_INVALID;
+    }
+    return s;
+}
+
+NetSocket netListen(int port, int backlog) {
+    NetSocket s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == NET_INVALID) return NET_INVALID;
+
+    // Let a restarted station take the port straight away
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(s, backlog) != 0 ||
+        !setNonBlocking(s)) {
+        netClose(s);
+        return NET_INVALID;
+    }
+    return s;
+}
+
+NetSocket netAccept(NetSocket listener) {
+    NetSocket s = accept(listener, nullptr, nullptr);
+    if (s == NET_INVALID) return NET_INVALID;
+    if (!setNonBlocking(s)) {
+        netClose(s);
+        return NET_INVALID;
+    }
+    return s;
+}
+
+bool netSetRecvTimeout(NetSocket s, int ms) {
+#ifdef _WIN32
+    DWORD timeout = (DWORD)ms;
+    return setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout)) == 0;
+#else
+    timeval timeout;
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_usec = (ms % 1000) * 1000;
+    return setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+#endif
+}
+
+bool netSendAll(NetSocket s, const char* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+#ifdef _WIN32
+        int ret = send(s, data + sent, (int)(len - sent), 0);
+#else
+        ssize_t ret = send(s, data + sent, len - sent, MSG_NOSIGNAL);
+#endif
+        if (ret < 0) {
+            // A non-blocking socket (the station's) can be full for a moment
+            if (interrupted()) continue;
+            if (wouldBlock() && waitWritable(s, SEND_WAIT_MS)) continue;
+            return false;
+        }
+        sent += (size_t)ret;
+    }
+    return true;
+}
+
+int netRecv(NetSocket s, char* buf, int len) {
+    int ret = (int)recv(s, buf, len, 0);
+    if (ret >= 0) return ret;
+    return wouldBlock() ? NET_WOULD_BLOCK : NET_ERROR;
+}
+
+int RecvBuffer::fill(NetSocket s) {
+    // Move the partial line to the front; grow only if one line fills it all
+    if (begin > 0) {
+        memmove(buf.data(), buf.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == buf.size()) {
+        if (buf.size() >= limit) return NET_TOO_LONG;
+        buf.resize(std::min(buf.size() * 2, limit));
+    }
+    int n = netRecv(s, buf.data() + end, (int)(buf.size() - end));
+    if (n > 0) end += (size_t)n;
+    return n;
+}
+
+bool RecvBuffer::nextLine(std::string_view& line) {
+    const char* start = buf.data() + begin;
+    const char* newline = (const char*)memchr(start, '\n', end - begin);
+    if (!newline) return false;
+    size_t len = (size_t)(newline - start);
+    begin += len + 1;
+    if (len > 0 && start[len - 1] == '\r') len--;
+    line = std::string_view(start, len);
+    return true;
+}
+
+#ifdef _WIN32
+
+Poller::Poller() {}
+
+Poller::~Poller() {}
+
+bool Poller::add(NetSocket s) {
+    WSAPOLLFD fd;
+    fd.fd = s;
+    fd.events = POLLRDNORM;
+    fd.revents = 0;
+    fds.push_back(fd);
+    return true;
+}
+
+void Poller::remove(NetSocket s) {
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i].fd == s) {
+            fds[i] = fds.back();
+            fds.pop_back();
+            return;
+        }
+    }
+}
+
+bool Poller::wait(std::vector<NetSocket>& ready, int timeoutMs) {
+    ready.clear();
+    if (fds.empty()) {
+        // WSAPoll rejects an empty set; wait out the timeout like epoll would
+        if (timeoutMs > 0) Sleep((DWORD)timeoutMs);
+        return true;
+    }
+    int n = WSAPoll(fds.data(), (ULONG)fds.size(), timeoutMs);
+    if (n < 0) return false;
+    for (const WSAPOLLFD& fd : fds) {
+        if (fd.revents) ready.push_back(fd.fd);
+    }
+    return true;
+}
+
+#else
+
+Poller::Poller() : epollFd(epoll_create1(0)), events(256) {}
+
+Poller::~Poller() {
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool Poller::add(NetSocket s) {
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = s;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, s, &ev) == 0;
+}
+
+void Poller::remove(NetSocket s) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, s, nullptr);
+}
+
+bool Poller::wait(std::vector<NetSocket>& ready, int timeoutMs) {
+    ready.clear();
+    int n = epoll_wait(epollFd, events.data(), (int)events.size(), timeoutMs);
+    if (n < 0) return errno == EINTR;
+    for (int i = 0; i < n; i++) {
+        ready.push_back(events[i].data.fd);
+    }
+    return true;
+}
+
+#endif
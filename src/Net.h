@@ -0,0 +1,118 @@
+#ifndef NET_H
+#define NET_H
+
+#include <vector>
+#include <string_view>
+#include <cstddef>
+#include <algorithm>
+
+// Thin TCP layer so the station and the drone build on Windows (Winsock)
+// and Linux (BSD sockets, epoll for readiness). Only what the two programs
+// need: blocking connect/send for the drone, a non-blocking listener,
+// accept and receive plus a readiness poller for the station.
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600     // WSAPoll
+#endif
+#include <winsock2.h>
+typedef SOCKET NetSocket;
+const NetSocket NET_INVALID = INVALID_SOCKET;
+#else
+#include <sys/socket.h>
+#include <sys/epoll.h>
+typedef int NetSocket;
+const NetSocket NET_INVALID = -1;
+#endif
+
+// Process-wide setup/teardown (WSAStartup / WSACleanup on Windows)
+bool netInit();
+void netCleanup();
+
+// Blocking connect to host:port; NET_INVALID on failure
+NetSocket netConnect(const char* host, int port);
+// Non-blocking listening socket on all interfaces; NET_INVALID on failure
+NetSocket netListen(int port, int backlog);
+// Accepts one pending connection as a non-blocking socket, or NET_INVALID
+// if none is waiting
+NetSocket netAccept(NetSocket listener);
+void netClose(NetSocket s);
+// Ends a connection without losing what is still in flight: stops sending,
+// reads and drops whatever the peer still sends until it closes (or a
+// receive waits 'timeoutMs'), then closes. A plain close with unread bytes
+// resets the connection, and the peer can lose data it has not read yet.
+void netCloseGracefully(NetSocket s, int timeoutMs);
+
+// Makes blocking receives on 's' give up after 'ms' milliseconds
+// (netRecv then returns NET_WOULD_BLOCK); 0 waits forever
+bool netSetRecvTimeout(NetSocket s, int ms);
+
+// Sends all of 'data', waiting out partial writes, interrupted calls and,
+// on a non-blocking socket, a full send buffer (for up to 5 seconds at a
+// time). False on error.
+bool netSendAll(NetSocket s, const char* data, size_t len);
+
+// Result of netRecv besides a byte count
+const int NET_WOULD_BLOCK = -1;
+const int NET_ERROR = -2;
+// RecvBuffer::fill: the buffer is at its limit without a complete message
+const int NET_TOO_LONG = -3;
+// Reads up to 'len' bytes: > 0 bytes read, 0 peer closed, or
+// NET_WOULD_BLOCK / NET_ERROR
+int netRecv(NetSocket s, char* buf, int len);
+
+// Receive buffer for one connection. Reads in large chunks and hands out
+// '\n'-terminated lines as views into the buffer, so nothing is copied per
+// message; binary frames are read straight from data() / size(). The
+// buffer grows for a long message up to 'limit' bytes, so a peer that never
+// ends one cannot make it grow without bound.
+class RecvBuffer {
+public:
+    explicit RecvBuffer(size_t capacity = 4096, size_t limit = 64 << 20)
+        : buf(std::min(capacity, limit)), limit(limit) {}
+
+    // One netRecv into the free end of the buffer; same return values, or
+    // NET_TOO_LONG once 'limit' unread bytes hold no complete message.
+    // Views and pointers into the buffer are invalid afterwards.
+    int fill(NetSocket s);
+
+    // The next complete line without its '\n' (or "\r\n"); false if only a
+    // partial line is buffered.
+    bool nextLine(std::string_view& line);
+
+    // Unread bytes
+    const char* data() const { return buf.data() + begin; }
+    size_t size() const { return end - begin; }
+    void consume(size_t n) { begin += n; }
+
+private:
+    std::vector<char> buf;
+    size_t limit;
+    size_t begin = 0, end = 0;   // unread bytes are buf[begin, end)
+};
+
+// Readiness for reading on many sockets: epoll on Linux, WSAPoll on
+// Windows. Level-triggered, so a socket with unread data stays ready.
+class Poller {
+public:
+    Poller();
+    ~Poller();
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    bool add(NetSocket s);
+    void remove(NetSocket s);
+
+    // Waits up to 'timeoutMs' (-1 = forever) and fills 'ready' with the
+    // sockets that can be read or were closed. Returns false on error.
+    bool wait(std::vector<NetSocket>& ready, int timeoutMs);
+
+private:
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> fds;
+#else
+    int epollFd;
+    std::vector<epoll_event> events;
+#endif
+};
+
+#endif // NET_H
@@ -0,0 +1,634 @@
+#include "Pathfinding.h"
+#include "Hpa.h"
+#include "Probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+const int DIR[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+
+// Times one query and reports it to the workspace on scope exit
+class QueryTimer {
+public:
+    explicit QueryTimer(PathWorkspace& ws)
+        : ws(ws), start(std::chrono::steady_clock::now()) {}
+    ~QueryTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ws.recordQuery((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+private:
+    PathWorkspace& ws;
+    std::chrono::steady_clock::time_point start;
+};
+
+const uint32_t STRAIGHT_COST = 10;
+const uint32_t DIAGONAL_COST = 14;
+
+// Octile distance: the exact cost of an unobstructed 8-connected move
+inline uint32_t octile(int r1, int c1, int r2, int c2) {
+    uint32_t dr = (uint32_t)std::abs(r1 - r2);
+    uint32_t dc = (uint32_t)std::abs(c1 - c2);
+    return dr < dc ? DIAGONAL_COST * dr + STRAIGHT_COST * (dc - dr)
+                   : DIAGONAL_COST * dc + STRAIGHT_COST * (dr - dc);
+}
+
+inline int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+// Walks the parent links from goal back to start and writes the path in
+// start-to-goal order. Consecutive links may be several cells apart (JPS);
+// they are always straight or diagonal, so the gaps are filled in.
+void buildPath(PathWorkspace& ws, int cols, int start, int goal,
+               std::vector<std::pair<int,int>>& path)
+{
+    for (int cell = goal; cell != start; ) {
+        int prev = ws.parentOf(cell);
+        int r = cell / cols, c = cell - r * cols;
+        int pr = prev / cols, pc = prev - pr * cols;
+        int dr = sign(pr - r), dc = sign(pc - c);
+        while (r != pr || c != pc) {
+            path.push_back({r, c});
+            r += dr;
+            c += dc;
+        }
+        cell = prev;
+    }
+    path.push_back({start / cols, start % cols});
+    std::reverse(path.begin(), path.end());
+}
+
+} // namespace
+
+void PathWorkspace::begin(int rows, int cols, bool withQueue) {
+    size_t cells = (size_t)rows * cols;
+    if (nodes.size() < cells) {
+        nodes.assign(cells, Node{0, 0, -1});
+        generation = 0;
+        stats.allocations++;
+    }
+    if (withQueue && queue.size() < cells + 1) {
+        size_t ring = 1;
+        while (ring < cells + 1) ring <<= 1;
+        queue.resize(ring);
+        queueMask = ring - 1;
+        stats.allocations++;
+    }
+    if (++generation == 0) {
+        // Stamps wrapped around: old marks could look current again
+        for (Node& n : nodes) n.stamp = 0;
+        generation = 1;
+    }
+    head = tail = 0;
+    heap.clear();
+}
+
+void PathWorkspace::heapPush(uint32_t f, uint32_t h, int cell) {
+    if (heap.size() == heap.capacity()) stats.allocations++;
+    heap.push_back({((uint64_t)f << 32) | h, cell});
+    std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+}
+
+int PathWorkspace::heapPop(uint32_t& f) {
+    std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+    HeapEntry top = heap.back();
+    heap.pop_back();
+    f = (uint32_t)(top.key >> 32);
+    return top.cell;
+}
+
+void PathWorkspace::recordQuery(uint64_t nanos) {
+    stats.queries++;
+    stats.totalNanos += nanos;
+    stats.maxNanos = std::max(stats.maxNanos, nanos);
+}
+
+// BFS pathfinding
+void getPathBFS(const GridMap& map, PathWorkspace& ws,
+                int startR, int startC, int goalR, int goalC,
+                std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.bfs");
+    QueryTimer timer(ws);
+    size_t capacity = path.capacity();
+    path.clear();
+    if (startR == goalR && startC == goalC) {
+        path.push_back({startR, startC});
+        if (path.capacity() != capacity) ws.noteAllocation();
+        return;
+    }
+    int rows = map.getRows();
+    int cols = map.getCols();
+    if (map.isFire(goalR, goalC)) {
+        return;
+    }
+    ws.begin(rows, cols);
+    int start = startR * cols + startC;
+    int goal = goalR * cols + goalC;
+    ws.visit(start, -1);
+    ws.push(start);
+
+    bool found = false;
+    while (!ws.queueEmpty() && !found) {
+        int cell = ws.pop();
+        ws.noteExpanded();
+        int r = cell / cols;
+        int c = cell - r * cols;
+        for (auto &d : DIR) {
+            int nr = r + d[0];
+            int nc = c + d[1];
+            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+            int next = nr * cols + nc;
+            if (ws.isVisited(next) || map.isFire(nr,nc)) continue;
+            ws.visit(next, cell);
+            ws.push(next);
+            if (next == goal) {
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        return;
+    }
+    buildPath(ws, cols, start, goal, path);
+    if (path.capacity() != capacity) ws.noteAllocation();
+}
+
+bool anyReachableUndiscovered(const GridMap& map,
+                              const DiscoveredLayer& discovered,
+                              PathWorkspace& ws,
+                              int droneRow, int droneCol)
+{
+    PROBE_SCOPE("path.anyReachable");
+    QueryTimer timer(ws);
+    int rows = map.getRows();
+    int cols = map.getCols();
+    ws.begin(rows, cols);
+    int start = droneRow * cols + droneCol;
+    ws.visit(start, -1);
+    ws.push(start);
+
+    while (!ws.queueEmpty()) {
+        int cell = ws.pop();
+        ws.noteExpanded();
+        int r = cell / cols;
+        int c = cell - r * cols;
+        if (!discovered.isDiscovered(r, c)) {
+            return true;
+        }
+        for (auto &d : DIR) {
+            int nr = r + d[0];
+            int nc = c + d[1];
+            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+            int next = nr * cols + nc;
+            if (ws.isVisited(next) || map.isFire(nr,nc)) continue;
+            ws.visit(next, cell);
+            ws.push(next);
+        }
+    }
+    return false;
+}
+
+namespace {
+
+// Undiscovered cells of the sensor footprint around (r, c), counted a row
+// at a time until there are 'limit'
+int undiscoveredAround(const DiscoveredLayer& discovered, const SensorFootprint& sensor,
+                       int r, int c, int limit)
+{
+    int count = 0;
+    int range = sensor.getRange();
+    int r0 = std::max(0, r - range), r1 = std::min(discovered.getRows() - 1, r + range);
+    for (int rr = r0; rr <= r1; rr++) {
+        int span = sensor.span(rr - r);
+        count += discovered.countUndiscovered(rr, c - span, c + span);
+        if (count >= limit) return count;
+    }
+    return count;
+}
+
+} // namespace
+
+bool findFrontierPath(const GridMap& map,
+                      const DiscoveredLayer& discovered,
+                      PathWorkspace& ws,
+                      int droneRow, int droneCol, const SensorFootprint& sensor,
+                      FrontierGoal goal, std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.frontier");
+    QueryTimer timer(ws);
+    size_t capacity = path.capacity();
+    path.clear();
+    int rows = map.getRows();
+    int cols = map.getCols();
+    ws.begin(rows, cols);
+    int start = droneRow * cols + droneCol;
+    ws.visit(start, -1);
+    ws.setCost(start, 0);
+    ws.push(start);
+
+    // BFS pops cells in order of moves, so the first cell with anything
+    // undiscovered around it is the nearest one. InfoGain keeps going for
+    // as many moves as the sensor's range (cells further out only add more
+    // flying) and keeps the best gain per move; ties go to the nearer cell.
+    int best = -1;
+    uint32_t bestMoves = 0, horizon = UINT32_MAX;
+    int bestGain = 0;
+    int range = sensor.getRange();
+    int window = sensor.area();
+    while (!ws.queueEmpty()) {
+        int cell = ws.pop();
+        uint32_t moves = ws.costOf(cell);
+        if (moves > horizon) break;
+        ws.noteExpanded();
+        int r = cell / cols;
+        int c = cell - r * cols;
+        int gain = undiscoveredAround(discovered, sensor, r, c,
+                                      goal == FrontierGoal::Nearest ? 1 : window);
+        if (gain > 0) {
+            if (best < 0) {
+                best = cell;
+                bestMoves = moves;
+                bestGain = gain;
+                if (goal == FrontierGoal::Nearest) break;
+                horizon = moves + range;
+            } else if ((uint64_t)gain * std::max(1u, bestMoves) > (uint64_t)bestGain * std::max(1u, moves)) {
+                best = cell;
+                bestMoves = moves;
+                bestGain = gain;
+            }
+        }
+        for (auto &d : DIR) {
+            int nr = r + d[0];
+            int nc = c + d[1];
+            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+            int next = nr * cols + nc;
+            if (ws.isVisited(next) || map.isFire(nr,nc)) continue;
+            ws.visit(next, cell);
+            ws.setCost(next, moves + 1);
+            ws.push(next);
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    buildPath(ws, cols, start, best, path);
+    if (path.capacity() != capacity) ws.noteAllocation();
+    return true;
+}
+
+bool findFrontierPath(const GridMap& map, const CoverageLayer& discovered,
+                      PathWorkspace& ws,
+                      int droneRow, int droneCol, int range, int colBegin, int colEnd,
+                      bool corridor, std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.frontier");
+    QueryTimer timer(ws);
+    size_t capacity = path.capacity();
+    path.clear();
+    int rows = map.getRows();
+    int cols = map.getCols();
+    int left = corridor ? std::max(colBegin - range, 0) : 0;
+    int right = corridor ? std::min(colEnd + range, cols) : cols;
+    ws.begin(rows, cols);
+    int start = droneRow * cols + droneCol;
+    ws.visit(start, -1);
+    ws.push(start);
+
+    int best = -1, nearest = -1;
+    while (!ws.queueEmpty()) {
+        int cell = ws.pop();
+        ws.noteExpanded();
+        int r = cell / cols;
+        int c = cell - r * cols;
+        bool inStrip = c >= colBegin && c < colEnd;
+        if ((inStrip || (!corridor && nearest < 0)) &&
+            discovered.anyUndiscovered(r - range, c - range, r + range, c + range)) {
+            if (inStrip) {
+                best = cell;
+                break;
+            }
+            nearest = cell;
+        }
+        for (auto &d : DIR) {
+            int nr = r + d[0];
+            int nc = c + d[1];
+            if (nr<0||nr>=rows||nc<left||nc>=right) continue;
+            int next = nr * cols + nc;
+            if (ws.isVisited(next) || map.isFire(nr,nc)) continue;
+            ws.visit(next, cell);
+            ws.push(next);
+        }
+    }
+    if (best < 0) best = nearest;
+    if (best < 0) {
+        return false;
+    }
+    buildPath(ws, cols, start, best, path);
+    if (path.capacity() != capacity) ws.noteAllocation();
+    return true;
+}
+
+void BfsPlanner::findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                          std::vector<std::pair<int,int>>& path)
+{
+    getPathBFS(map, ws, startR, startC, goalR, goalC, path);
+}
+
+void AStarPlanner::findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                            std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.astar");
+    QueryTimer timer(ws);
+    size_t capacity = path.capacity();
+    path.clear();
+    if (startR == goalR && startC == goalC) {
+        path.push_back({startR, startC});
+        if (path.capacity() != capacity) ws.noteAllocation();
+        return;
+    }
+    int rows = map.getRows();
+    int cols = map.getCols();
+    if (map.isFire(goalR, goalC)) {
+        return;
+    }
+    ws.begin(rows, cols, false);
+    int start = startR * cols + startC;
+    int goal = goalR * cols + goalC;
+    ws.visit(start, -1);
+    ws.setCost(start, 0);
+    ws.heapPush(octile(startR, startC, goalR, goalC), octile(startR, startC, goalR, goalC), start);
+
+    bool found = false;
+    while (!ws.heapEmpty()) {
+        uint32_t f;
+        int cell = ws.heapPop(f);
+        int r = cell / cols;
+        int c = cell - r * cols;
+        uint32_t g = ws.costOf(cell);
+        // Stale entry: the cell was pushed again later with a lower cost
+        if (f != g + octile(r, c, goalR, goalC)) continue;
+        ws.noteExpanded();
+        if (cell == goal) {
+            found = true;
+            break;
+        }
+        for (auto &d : DIR) {
+            int nr = r + d[0];
+            int nc = c + d[1];
+            if (nr<0||nr>=rows||nc<0||nc>=cols) continue;
+            if (map.isFire(nr,nc)) continue;
+            int next = nr * cols + nc;
+            uint32_t ng = g + (d[0] && d[1] ? DIAGONAL_COST : STRAIGHT_COST);
+            if (ws.isVisited(next) && ws.costOf(next) <= ng) continue;
+            ws.visit(next, cell);
+            ws.setCost(next, ng);
+            uint32_t h = octile(nr, nc, goalR, goalC);
+            ws.heapPush(ng + h, h, next);
+        }
+    }
+    if (!found) {
+        return;
+    }
+    buildPath(ws, cols, start, goal, path);
+    if (path.capacity() != capacity) ws.noteAllocation();
+}
+
+void MapFilePlanner::findPath(const MapFile& file, int startR, int startC, int goalR, int goalC,
+                              std::vector<std::pair<int,int>>& path, uint64_t maxExpanded)
+{
+    auto begin = std::chrono::steady_clock::now();
+    path.clear();
+    nodes.clear();
+    heap.clear();
+    uint64_t cols = (uint64_t)file.getCols();
+    int rows = file.getRows();
+    uint64_t start = startR * cols + startC;
+    uint64_t goal = goalR * cols + goalC;
+    auto heuristic = [&](int r, int c) { return (uint32_t)(octile(r, c, goalR, goalC) * weight); };
+    bool found = start == goal;
+    if (!found && !file.isFire(goalR, goalC)) {
+        nodes[start] = Node{0, 0};
+        uint32_t h0 = heuristic(startR, startC);
+        heap.push_back({((uint64_t)h0 << 32) | h0, start});
+    }
+    uint64_t expanded = 0;
+    while (!found && !heap.empty() && (maxExpanded == 0 || expanded < maxExpanded)) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        HeapEntry top = heap.back();
+        heap.pop_back();
+        int r = (int)(top.cell / cols);
+        int c = (int)(top.cell - r * cols);
+        uint32_t g = nodes[top.cell].cost;
+        // Stale entry: the cell was pushed again later with a lower cost
+        if ((uint32_t)(top.key >> 32) != g + heuristic(r, c)) continue;
+        expanded++;
+        if (top.cell == goal) {
+            found = true;
+            break;
+        }
+        for (int d = 0; d < 8; d++) {
+            int nr = r + DIR[d][0];
+            int nc = c + DIR[d][1];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= (int)cols) continue;
+            if (file.isFire(nr, nc)) continue;
+            uint32_t ng = g + (DIR[d][0] && DIR[d][1] ? DIAGONAL_COST : STRAIGHT_COST);
+            auto [it, inserted] = nodes.try_emplace(nr * cols + nc, Node{ng, (uint8_t)d});
+            if (!inserted) {
+                if (it->second.cost <= ng) continue;
+                it->second = Node{ng, (uint8_t)d};
+            }
+            uint32_t h = heuristic(nr, nc);
+            heap.push_back({((uint64_t)(ng + h) << 32) | h, nr * cols + nc});
+            std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        }
+    }
+    if (found) {
+        // Step back along the recorded moves
+        int r = goalR, c = goalC;
+        path.push_back({r, c});
+        while (r != startR || c != startC) {
+            const int* d = DIR[nodes[r * cols + c].from];
+            r -= d[0];
+            c -= d[1];
+            path.push_back({r, c});
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    stats.queries++;
+    stats.expanded += expanded;
+    stats.maxNodes = std::max(stats.maxNodes, (uint64_t)nodes.size());
+    stats.totalNanos += nanos;
+    stats.maxNanos = std::max(stats.maxNanos, nanos);
+}
+
+size_t MapFilePlanner::stateBytes() const {
+    // A hash node holds the key, the value and a link; the buckets are one
+    // pointer each
+    return nodes.size() * (sizeof(uint64_t) + sizeof(Node) + sizeof(void*)) +
+           nodes.bucket_count() * sizeof(void*) + heap.capacity() * sizeof(HeapEntry);
+}
+
+namespace {
+
+// Helpers for JPS; cells off the map count as blocked.
+struct JumpContext {
+    const GridMap& map;
+    int rows, cols, goalR, goalC;
+
+    bool open(int r, int c) const {
+        return r >= 0 && r < rows && c >= 0 && c < cols && !map.isFire(r, c);
+    }
+    bool blocked(int r, int c) const {
+        return !open(r, c);
+    }
+
+    // A neighbour that can only be reached optimally through (r, c) when
+    // arriving in direction (dr, dc) - the classic JPS forced neighbours for
+    // grids that allow corner cutting.
+    bool hasForced(int r, int c, int dr, int dc) const {
+        if (dr && dc) {
+            return (blocked(r - dr, c) && open(r - dr, c + dc))
+                || (blocked(r, c - dc) && open(r + dr, c - dc));
+        }
+        if (dr) {
+            return (blocked(r, c - 1) && open(r + dr, c - 1))
+                || (blocked(r, c + 1) && open(r + dr, c + 1));
+        }
+        return (blocked(r - 1, c) && open(r - 1, c + dc))
+            || (blocked(r + 1, c) && open(r + 1, c + dc));
+    }
+
+    // Steps from (r, c) in direction (dr, dc) until it finds a jump point
+    // (returned as a cell index) or runs into fire / the edge (-1).
+    int jump(int r, int c, int dr, int dc) const {
+        while (true) {
+            r += dr;
+            c += dc;
+            if (!open(r, c)) return -1;
+            if ((r == goalR && c == goalC) || hasForced(r, c, dr, dc)) return r * cols + c;
+            // A diagonal move stops wherever a straight jump would find something
+            if (dr && dc && (jump(r, c, dr, 0) >= 0 || jump(r, c, 0, dc) >= 0)) {
+                return r * cols + c;
+            }
+        }
+    }
+};
+
+} // namespace
+
+void JpsPlanner::findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                          std::vector<std::pair<int,int>>& path)
+{
+    PROBE_SCOPE("path.jps");
+    QueryTimer timer(ws);
+    size_t capacity = path.capacity();
+    path.clear();
+    if (startR == goalR && startC == goalC) {
+        path.push_back({startR, startC});
+        if (path.capacity() != capacity) ws.noteAllocation();
+        return;
+    }
+    int rows = map.getRows();
+    int cols = map.getCols();
+    if (map.isFire(goalR, goalC)) {
+        return;
+    }
+    JumpContext jc{map, rows, cols, goalR, goalC};
+    ws.begin(rows, cols, false);
+    int start = startR * cols + startC;
+    int goal = goalR * cols + goalC;
+    ws.visit(start, -1);
+    ws.setCost(start, 0);
+    ws.heapPush(octile(startR, startC, goalR, goalC), octile(startR, startC, goalR, goalC), start);
+
+    bool found = false;
+    while (!ws.heapEmpty()) {
+        uint32_t f;
+        int cell = ws.heapPop(f);
+        int r = cell / cols;
+        int c = cell - r * cols;
+        uint32_t g = ws.costOf(cell);
+        if (f != g + octile(r, c, goalR, goalC)) continue;
+        ws.noteExpanded();
+        if (cell == goal) {
+            found = true;
+            break;
+        }
+
+        // Directions worth jumping in: all 8 from the start, otherwise the
+        // natural and forced neighbours for the direction we arrived from.
+        int dirs[8][2];
+        int count = 0;
+        int parentCell = ws.parentOf(cell);
+        if (parentCell < 0) {
+            for (auto &d : DIR) {
+                dirs[count][0] = d[0];
+                dirs[count][1] = d[1];
+                count++;
+            }
+        } else {
+            int pr = parentCell / cols;
+            int dr = sign(r - pr), dc = sign(c - (parentCell - pr * cols));
+            auto add = [&](int a, int b) { dirs[count][0] = a; dirs[count][1] = b; count++; };
+            if (dr && dc) {
+                add(dr, dc);
+                add(dr, 0);
+                add(0, dc);
+                if (jc.blocked(r - dr, c)) add(-dr, dc);
+                if (jc.blocked(r, c - dc)) add(dr, -dc);
+            } else if (dr) {
+                add(dr, 0);
+                if (jc.blocked(r, c - 1)) add(dr, -1);
+                if (jc.blocked(r, c + 1)) add(dr, 1);
+            } else {
+                add(0, dc);
+                if (jc.blocked(r - 1, c)) add(-1, dc);
+                if (jc.blocked(r + 1, c)) add(1, dc);
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            int next = jc.jump(r, c, dirs[i][0], dirs[i][1]);
+            if (next < 0) continue;
+            int nr = next / cols;
+            int nc = next - nr * cols;
+            uint32_t ng = g + octile(r, c, nr, nc);
+            if (ws.isVisited(next) && ws.costOf(next) <= ng) continue;
+            ws.visit(next, cell);
+            ws.setCost(next, ng);
+            uint32_t h = octile(nr, nc, goalR, goalC);
+            ws.heapPush(ng + h, h, next);
+        }
+    }
+    if (!found) {
+        return;
+    }
+    buildPath(ws, cols, start, goal, path);
+    if (path.capacity() != capacity) ws.noteAllocation();
+}
+
+std::unique_ptr<PathPlanner> makePlanner(const std::string& name)
+{
+    if (name == "bfs")   return std::make_unique<BfsPlanner>();
+    if (name == "astar") return std::make_unique<AStarPlanner>();
+    if (name == "jps")   return std::make_unique<JpsPlanner>();
+    if (name == "hpa")   return std::make_unique<HpaPlanner>();
+    return nullptr;
+}
+
+uint32_t pathCost(const std::vector<std::pair<int,int>>& path)
+{
+    uint32_t total = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+        total += octile(path[i - 1].first, path[i - 1].second, path[i].first, path[i].second);
+    }
+    return total;
+}
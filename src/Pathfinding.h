@@ -0,0 +1,236 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "GridMap.h"
+#include "Coverage.h"
+#include "Sensor.h"
+#include "MapFile.h"
+
+// Reusable scratch space for grid searches. Buffers are flat (one entry
+// per cell, row-major) and sized once per map, so repeated queries on the
+// same map allocate nothing:
+//  - 'visited' is a generation stamp per cell; starting a new query just
+//    bumps the generation, which clears every mark in O(1).
+//  - the BFS frontier is a ring buffer over a preallocated array.
+class PathWorkspace {
+public:
+    struct Stats {
+        uint64_t queries = 0;
+        uint64_t expanded = 0;      // nodes taken off the open list / queue
+        uint64_t allocations = 0;   // buffer (re)allocations, including result paths
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+    };
+
+    // Grows the buffers for a rows x cols map and starts a fresh query.
+    // Heap-only searches leave out the BFS queue, a third of the memory.
+    void begin(int rows, int cols, bool withQueue = true);
+
+    bool isVisited(int cell) const { return nodes[cell].stamp == generation; }
+    void visit(int cell, int parentCell) {
+        nodes[cell].stamp = generation;
+        nodes[cell].parent = parentCell;
+    }
+    int parentOf(int cell) const { return nodes[cell].parent; }
+
+    // Path cost from the start; only meaningful for visited cells
+    uint32_t costOf(int cell) const { return nodes[cell].cost; }
+    void setCost(int cell, uint32_t g) { nodes[cell].cost = g; }
+
+    // Binary min-heap for best-first searches, ordered by f = g + h and,
+    // among equal f, by smaller h (the entry closest to the goal first)
+    void heapPush(uint32_t f, uint32_t h, int cell);
+    int heapPop(uint32_t& f);
+    bool heapEmpty() const { return heap.empty(); }
+
+    void push(int cell) {
+        queue[tail] = cell;
+        tail = (tail + 1) & queueMask;
+    }
+    int pop() {
+        int cell = queue[head];
+        head = (head + 1) & queueMask;
+        return cell;
+    }
+    bool queueEmpty() const { return head == tail; }
+
+    // Record that a result vector had to grow
+    void noteAllocation() { stats.allocations++; }
+    void noteExpanded() { stats.expanded++; }
+    void recordQuery(uint64_t nanos);
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    // Per-cell search state, kept together so a visit touches one cache line
+    struct Node {
+        uint32_t stamp;
+        uint32_t cost;
+        int parent;
+    };
+    std::vector<Node> nodes;
+    std::vector<int> queue;   // power-of-two ring, at least one slot per cell
+    struct HeapEntry {
+        uint64_t key;   // (f << 32) | h
+        int cell;
+        bool operator>(const HeapEntry& o) const { return key > o.key; }
+    };
+    std::vector<HeapEntry> heap;
+    uint32_t generation = 0;
+    size_t queueMask = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    Stats stats;
+};
+
+// BFS pathfinding over the 8-connected grid, avoiding fire cells.
+// Fills 'path' with the cells from start to goal (both included), or leaves
+// it empty if the goal cannot be reached. 'path' keeps its capacity, so
+// reusing the same vector avoids reallocating it.
+void getPathBFS(const GridMap& map, PathWorkspace& ws,
+                int startR, int startC, int goalR, int goalC,
+                std::vector<std::pair<int,int>>& path);
+
+// True if some undiscovered cell can be reached from the drone's position.
+bool anyReachableUndiscovered(const GridMap& map,
+                              const DiscoveredLayer& discovered,
+                              PathWorkspace& ws,
+                              int droneRow, int droneCol);
+
+// What frontier exploration flies to next
+//  Nearest:  the closest cell that would reveal anything.
+//  InfoGain: the cell that reveals the most undiscovered cells per move,
+//            looking up to the sensor's range in moves past the closest one.
+enum class FrontierGoal { Nearest, InfoGain };
+
+// One BFS pass from the drone over non-fire cells that picks the next place
+// to explore: a reachable cell with undiscovered cells inside the sensor's
+// footprint around it (occlusion aside). Fills 'path' from the drone to
+// that cell and returns true, or returns false with 'path' empty when no
+// reachable cell would reveal anything new, i.e. exploration is over.
+bool findFrontierPath(const GridMap& map,
+                      const DiscoveredLayer& discovered,
+                      PathWorkspace& ws,
+                      int droneRow, int droneCol, const SensorFootprint& sensor,
+                      FrontierGoal goal, std::vector<std::pair<int,int>>& path);
+
+// The same search for one drone of a fleet: 'discovered' is the layer the
+// drones share and the goal is the nearest cell in columns [colBegin,
+// colEnd). If there is none, the nearest cell anywhere is taken instead
+// (check the path's end to tell). With 'corridor' the search stays within
+// 'range' columns of the strip and takes only targets inside it.
+bool findFrontierPath(const GridMap& map, const CoverageLayer& discovered,
+                      PathWorkspace& ws,
+                      int droneRow, int droneCol, int range, int colBegin, int colEnd,
+                      bool corridor, std::vector<std::pair<int,int>>& path);
+
+// Common interface of the grid planners, so the sweep can switch between
+// them. Every planner searches the same 8-connected grid, may cut corners
+// between two fire cells like the original BFS, and owns its workspace.
+class PathPlanner {
+public:
+    virtual ~PathPlanner() = default;
+    virtual const char* name() const = 0;
+    // Same contract as getPathBFS
+    virtual void findPath(const GridMap& map,
+                          int startR, int startC, int goalR, int goalC,
+                          std::vector<std::pair<int,int>>& path) = 0;
+    // Cells (row * cols + col) of the map last searched that caught fire
+    // since; planners that keep state about the map update it here
+    virtual void cellsBlocked(const std::vector<int>& cells) { (void)cells; }
+    // Forgets what the planner keeps about the map, for a map that was
+    // cleared and refilled in place
+    virtual void reset() {}
+
+    PathWorkspace& workspace() { return ws; }
+    const PathWorkspace::Stats& getStats() const { return ws.getStats(); }
+
+protected:
+    PathWorkspace ws;
+};
+
+// Unweighted breadth-first search: fewest moves, diagonals count as 1.
+class BfsPlanner : public PathPlanner {
+public:
+    const char* name() const override { return "bfs"; }
+    void findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                  std::vector<std::pair<int,int>>& path) override;
+};
+
+// A* with octile costs (straight 10, diagonal 14) and the octile-distance
+// heuristic, on a binary heap.
+class AStarPlanner : public PathPlanner {
+public:
+    const char* name() const override { return "astar"; }
+    void findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                  std::vector<std::pair<int,int>>& path) override;
+};
+
+// Jump Point Search: A* that only puts jump points on the open list.
+// Same path costs as AStarPlanner, far fewer heap operations on open maps.
+class JpsPlanner : public PathPlanner {
+public:
+    const char* name() const override { return "jps"; }
+    void findPath(const GridMap& map, int startR, int startC, int goalR, int goalC,
+                  std::vector<std::pair<int,int>>& path) override;
+};
+
+// A* on a MapFile, for maps too large for a GridMap and its workspace:
+// the same moves, costs and heuristic as AStarPlanner, but the search state
+// lives in a hash table that grows with the cells the search reaches rather
+// than with the map, and only the tiles along the way are read from disk.
+class MapFilePlanner {
+public:
+    struct Stats {
+        uint64_t queries = 0;
+        uint64_t expanded = 0;
+        uint64_t maxNodes = 0;      // most cells one query held state for
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+    };
+
+    // Same contract as getPathBFS. Gives up with 'path' empty after
+    // 'maxExpanded' expansions, 0 = no limit.
+    void findPath(const MapFile& file, int startR, int startC, int goalR, int goalC,
+                  std::vector<std::pair<int,int>>& path, uint64_t maxExpanded = 0);
+
+    // Weighted A*: the heuristic counts 'weight' times over. Above 1 the
+    // path may cost up to that factor more than the best one, but the
+    // search stops expanding every cell that ties with it, which on long
+    // legs through scattered fires is nearly all of them. Default 1.
+    void setWeight(double w) { weight = w; }
+
+    const Stats& getStats() const { return stats; }
+    // Rough size of the search state at the end of the last query
+    size_t stateBytes() const;
+
+private:
+    struct Node {
+        uint32_t cost;
+        uint8_t from;       // index of the move that reached the cell
+    };
+    struct HeapEntry {
+        uint64_t key;       // (f << 32) | h, like PathWorkspace
+        uint64_t cell;
+        bool operator>(const HeapEntry& o) const { return key > o.key; }
+    };
+    std::unordered_map<uint64_t, Node> nodes;
+    std::vector<HeapEntry> heap;
+    double weight = 1.0;
+    Stats stats;
+};
+
+// "bfs", "astar", "jps" or "hpa"; returns nullptr for anything else.
+std::unique_ptr<PathPlanner> makePlanner(const std::string& name);
+
+// Octile path cost (10 per straight move, 14 per diagonal) of a cell path.
+uint32_t pathCost(const std::vector<std::pair<int,int>>& path);
+
+#endif // PATHFINDING_H
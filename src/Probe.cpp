@@ -0,0 +1,151 @@
+#include "Probe.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+// One site's numbers on one thread. Only that thread writes them, so plain
+// load-then-store is enough; the atomics let the report read them safely.
+struct Slot {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max;
+    std::atomic<uint32_t> buckets[PROBE_BUCKETS];
+};
+
+struct Block {
+    Slot slots[MAX_PROBE_SITES];
+};
+
+struct SiteInfo {
+    std::string name;
+    ProbeKind kind;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<SiteInfo> sites;
+    std::vector<std::unique_ptr<Block>> blocks;     // outlive their threads
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+Block* newBlock() {
+    Registry& r = registry();
+    auto block = std::make_unique<Block>();     // value-initialised: all zero
+    Block* raw = block.get();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.blocks.push_back(std::move(block));
+    return raw;
+}
+
+// Bucket of a value: exact below 8, then 8 buckets per power of two
+int bucketOf(uint64_t v) {
+    if (v < 8) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return (e - 2) * 8 + (int)((v >> (e - 3)) & 7);
+}
+
+// Middle of a bucket's range
+double bucketValue(int b) {
+    if (b < 8) return b;
+    int shift = b / 8 - 1;
+    double low = (double)((uint64_t)(8 + b % 8) << shift);
+    return low + (double)(1ULL << shift) / 2;
+}
+
+inline void bump(std::atomic<uint64_t>& a, uint64_t by) {
+    a.store(a.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+// The value below which a fraction q of the samples fall
+double percentile(const std::vector<uint64_t>& hist, uint64_t count, double q) {
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5));
+    uint64_t seen = 0;
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= rank) return bucketValue(b);
+    }
+    return 0;
+}
+
+} // namespace
+
+ProbeSite::ProbeSite(const char* name, ProbeKind kind) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    // Sites with the same name (two overloads, say) share one slot
+    for (size_t i = 0; i < r.sites.size(); i++) {
+        if (r.sites[i].name == name) {
+            slot = (int)i;
+            return;
+        }
+    }
+    slot = (int)r.sites.size() < MAX_PROBE_SITES ? (int)r.sites.size() : -1;
+    if (slot >= 0) r.sites.push_back({name, kind});
+}
+
+void probeRecord(int site, uint64_t value) {
+    if (site < 0) return;
+    thread_local Block* block = nullptr;
+    if (!block) block = newBlock();
+    Slot& s = block->slots[site];
+    bump(s.count, 1);
+    bump(s.total, value);
+    if (value > s.max.load(std::memory_order_relaxed)) s.max.store(value, std::memory_order_relaxed);
+    std::atomic<uint32_t>& bucket = s.buckets[bucketOf(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void probeReportJson(std::ostream& out) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    std::string timers, counters;
+    std::vector<uint64_t> hist(PROBE_BUCKETS);
+    for (size_t i = 0; i < r.sites.size(); i++) {
+        uint64_t count = 0, total = 0, max = 0;
+        std::fill(hist.begin(), hist.end(), 0);
+        for (const auto& block : r.blocks) {
+            const Slot& s = block->slots[i];
+            count += s.count.load(std::memory_order_relaxed);
+            total += s.total.load(std::memory_order_relaxed);
+            max = std::max(max, s.max.load(std::memory_order_relaxed));
+            for (int b = 0; b < PROBE_BUCKETS; b++) hist[b] += s.buckets[b].load(std::memory_order_relaxed);
+        }
+        std::string entry = "\"" + r.sites[i].name + "\":{\"count\":" + std::to_string(count);
+        if (r.sites[i].kind == ProbeKind::Counter) {
+            entry += ",\"total\":" + std::to_string(total) + "}";
+            counters += (counters.empty() ? "" : ",") + entry;
+            continue;
+        }
+        // Bucket middles can overshoot the largest sample
+        auto us = [&](double nanos) { return std::to_string(std::min(nanos, (double)max) / 1e3); };
+        entry += ",\"totalMs\":" + std::to_string(total / 1e6) +
+                 ",\"p50Us\":" + us(count ? percentile(hist, count, 0.50) : 0) +
+                 ",\"p99Us\":" + us(count ? percentile(hist, count, 0.99) : 0) +
+                 ",\"maxUs\":" + us((double)max) + "}";
+        timers += (timers.empty() ? "" : ",") + entry;
+    }
+    out << "{\"timers\":{" << timers << "},\"counters\":{" << counters << "}}";
+}
+
+void probeReset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (const auto& block : r.blocks) {
+        for (Slot& s : block->slots) {
+            s.count.store(0, std::memory_order_relaxed);
+            s.total.store(0, std::memory_order_relaxed);
+            s.max.store(0, std::memory_order_relaxed);
+            for (auto& b : s.buckets) b.store(0, std::memory_order_relaxed);
+        }
+    }
+}
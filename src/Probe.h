@@ -0,0 +1,85 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+
+// Hot-path instrumentation: scoped timers and counters that cost nothing
+// unless the build defines DRONE_PROBES (make PROBES=1).
+//
+//   PROBE_SCOPE("path.bfs");           // times the rest of the block
+//   PROBE_COUNT("net.bytes", n);       // adds n to a counter
+//
+// Each thread records into blocks of its own, with no locks or shared
+// cache lines, so probes on pool threads do not slow each other down.
+// Timers keep a log-linear histogram of their durations (8 buckets per
+// power of two, so percentiles are within 12.5%). probeReportJson() merges
+// every thread's blocks at the end of a run.
+
+// Most probe sites in one program; more are ignored
+const int MAX_PROBE_SITES = 64;
+// Histogram buckets: 8 per power of two up to 2^63 ns
+const int PROBE_BUCKETS = 496;
+
+enum class ProbeKind { Timer, Counter };
+
+// One call site; a function-local static, registered on first use
+class ProbeSite {
+public:
+    ProbeSite(const char* name, ProbeKind kind);
+    int index() const { return slot; }
+
+private:
+    int slot;
+};
+
+// Records one timer sample or counter increment for 'site' on the calling
+// thread
+void probeRecord(int site, uint64_t value);
+
+// Timers and counters recorded so far, as one JSON object:
+//   {"timers":{"path.bfs":{"count":N,"totalMs":..,"p50Us":..,"p99Us":..,"maxUs":..},...},
+//    "counters":{"net.bytes":{"count":N,"total":..},...}}
+// Call it once the threads that record have finished, or accept numbers
+// that are a moment old.
+void probeReportJson(std::ostream& out);
+
+// Forgets everything recorded (benchmarks between runs)
+void probeReset();
+
+class ScopedProbe {
+public:
+    explicit ScopedProbe(int site) : site(site), start(std::chrono::steady_clock::now()) {}
+    ~ScopedProbe() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        probeRecord(site, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+private:
+    int site;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROBE_CONCAT2(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT2(a, b)
+
+#ifdef DRONE_PROBES
+const bool PROBES_ENABLED = true;
+#define PROBE_SCOPE(name)                                                           \
+    static const ProbeSite PROBE_CONCAT(probeSite, __LINE__)(name, ProbeKind::Timer); \
+    ScopedProbe PROBE_CONCAT(probeScope, __LINE__)(PROBE_CONCAT(probeSite, __LINE__).index())
+#define PROBE_COUNT(name, n)                                                          \
+    do {                                                                              \
+        static const ProbeSite probeCounter(name, ProbeKind::Counter);                \
+        probeRecord(probeCounter.index(), (uint64_t)(n));                             \
+    } while (0)
+#else
+const bool PROBES_ENABLED = false;
+#define PROBE_SCOPE(name) ((void)0)
+#define PROBE_COUNT(name, n) ((void)0)
+#endif
+
+#endif // PROBE_H
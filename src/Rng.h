@@ -0,0 +1,87 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <cmath>
+
+// Counter-based random numbers: every draw is a pure function of a key and
+// a counter, so there is no shared generator state to serialize on and the
+// same (key, counter) always gives the same value. Xoshiro256 below is the
+// sequential generator for code that just wants the next number.
+
+// SplitMix64 finalizer - a fast, well-mixed 64-bit bijection.
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// One mixing round per draw; the odd multiplier spreads consecutive
+// counters across the whole word before mixing.
+inline uint64_t counterHash(uint64_t key, uint64_t counter) {
+    return mix64(key ^ (counter * 0xD1B54A32D192ED03ULL));
+}
+
+// Top 53 bits of a hash, i.e. a uniform integer in [0, 2^53).
+inline uint64_t unit53(uint64_t h) {
+    return h >> 11;
+}
+
+// Probability p in [0, 1] scaled to the unit53() range, so that
+// unit53(h) < probabilityThreshold(p) happens with probability p.
+inline uint64_t probabilityThreshold(double p) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return 1ULL << 53;
+    return (uint64_t)(p * 9007199254740992.0); // 2^53
+}
+
+// xoshiro256** (Blackman and Vigna): a small, fast sequential generator
+// with 256 bits of state. Each owner keeps its own, seeded explicitly, so
+// threads never share one and a seed always gives the same sequence.
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        // Spread the seed over the state with SplitMix64, as its authors
+        // recommend; the state is never all zero
+        for (int i = 0; i < 4; i++) s[i] = mix64(seed + i * 0x9E3779B97F4A7C15ULL);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n), n > 0 (Lemire's multiply-shift, bias below 2^-32
+    // for the map sizes used here)
+    uint32_t below(uint32_t n) {
+        return (uint32_t)(((next() >> 32) * n) >> 32);
+    }
+
+    // Uniform in (0, 1]: never 0, so log() of it is finite
+    double unit() {
+        return (unit53(next()) + 1) * (1.0 / 9007199254740992.0);
+    }
+
+    // Cells to skip before the next hit when each cell is a hit with
+    // probability p (0 < p < 1): geometric with log(1 - p) = 'logMiss', so
+    // sparse draws cost one number per hit instead of one per cell. Capped
+    // at 2^62 so callers can add to it without wrapping.
+    uint64_t skip(double logMiss) {
+        double gap = std::floor(std::log(unit()) / logMiss);
+        return gap < 4.6e18 ? (uint64_t)gap : 1ULL << 62;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    uint64_t s[4];
+};
+
+#endif // RNG_H
@@ -0,0 +1,121 @@
+#include "SendQueue.h"
+#include "Probe.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const size_t MARKS = 4096;
+
+// The sender is woken early only once this much is waiting; smaller
+// messages wait for its next tick, so a stream of tiny reports does not
+// cost a thread switch each
+const size_t WAKE_BYTES = 4096;
+const auto TICK = std::chrono::milliseconds(1);
+
+} // namespace
+
+SendQueue::SendQueue(NetSocket sock, size_t capacity)
+    : sock(sock), marks(MARKS)
+{
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    ring.resize(size);
+    mask = size - 1;
+    sender = std::thread(&SendQueue::senderLoop, this);
+}
+
+SendQueue::~SendQueue() {
+    close();
+}
+
+size_t SendQueue::push(const char* data, size_t len) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    size_t space = ring.size() - (size_t)(h - tail.load(std::memory_order_acquire));
+    size_t n = std::min(len, space);
+    if (n == 0) return 0;
+
+    size_t at = (size_t)h & mask;
+    size_t first = std::min(n, ring.size() - at);
+    memcpy(ring.data() + at, data, first);
+    memcpy(ring.data(), data + first, n - first);
+
+    if (n == len) {
+        uint64_t m = markHead.load(std::memory_order_relaxed);
+        if (m - markTail.load(std::memory_order_acquire) < marks.size()) {
+            marks[m % marks.size()] = {h + n, Clock::now()};
+            markHead.store(m + 1, std::memory_order_release);
+        }
+    }
+    head.store(h + n, std::memory_order_seq_cst);
+    stats.maxDepth = std::max<uint64_t>(stats.maxDepth, h + n - tail.load(std::memory_order_relaxed));
+
+    // Wake the sender only if it went to sleep and enough is waiting
+    if (h + n - tail.load(std::memory_order_relaxed) >= WAKE_BYTES &&
+        sleeping.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+    return n;
+}
+
+size_t SendQueue::depth() const {
+    return (size_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+}
+
+void SendQueue::close() {
+    if (!sender.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_one();
+    sender.join();
+}
+
+void SendQueue::senderLoop() {
+    while (true) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            std::unique_lock<std::mutex> lock(sleepLock);
+            sleeping.store(true, std::memory_order_seq_cst);
+            wake.wait_for(lock, TICK, [&] {
+                return head.load(std::memory_order_seq_cst) - t >= WAKE_BYTES || stopping.load();
+            });
+            sleeping.store(false, std::memory_order_relaxed);
+            if (stopping.load() && head.load(std::memory_order_acquire) == t) return;  // drained
+            continue;
+        }
+
+        // Send the contiguous part up to the wrap point
+        size_t at = (size_t)t & mask;
+        size_t n = (size_t)std::min<uint64_t>(h - t, ring.size() - at);
+        if (!stats.failed) {
+            PROBE_SCOPE("net.queueSend");
+            PROBE_COUNT("net.bytes", n);
+            if (netSendAll(sock, ring.data() + at, n)) {
+                stats.bytes += n;
+                stats.sends++;
+            } else {
+                stats.failed = true;
+            }
+        }
+        tail.store(t + n, std::memory_order_release);
+
+        // Latency of every message that is now fully sent
+        auto now = Clock::now();
+        uint64_t m = markTail.load(std::memory_order_relaxed);
+        uint64_t mh = markHead.load(std::memory_order_acquire);
+        while (m != mh && marks[m % marks.size()].end <= t + n) {
+            uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - marks[m % marks.size()].pushed).count();
+            stats.messages++;
+            stats.latencyNanos += nanos;
+            stats.maxLatencyNanos = std::max(stats.maxLatencyNanos, nanos);
+            m++;
+        }
+        markTail.store(m, std::memory_order_release);
+    }
+}
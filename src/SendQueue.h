@@ -0,0 +1,86 @@
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Net.h"
+
+// Hands outgoing bytes to a sender thread so a slow or stalled station
+// never blocks the thread that produces them.
+//  - One producer, one consumer: a fixed byte ring with atomic read and
+//    write counters, no lock on the data path.
+//  - Memory is bounded by the ring. push() takes only what fits and
+//    returns how much; the caller keeps the rest and coalesces new data
+//    into it (back-pressure stays with the producer).
+//  - The sender sleeps on a condition variable when the ring is empty,
+//    checking back every millisecond; a push wakes it early only when it
+//    is asleep and a few KB are waiting.
+class SendQueue {
+public:
+    struct Stats {
+        uint64_t bytes = 0;         // bytes sent
+        uint64_t sends = 0;         // send calls
+        uint64_t maxDepth = 0;      // most bytes waiting in the ring
+        uint64_t messages = 0;      // completed pushes with a latency sample
+        uint64_t latencyNanos = 0;  // push -> sent, summed over 'messages'
+        uint64_t maxLatencyNanos = 0;
+        bool failed = false;        // the socket failed; later bytes were dropped
+    };
+
+    // 'capacity' is rounded up to a power of two
+    SendQueue(NetSocket sock, size_t capacity);
+    ~SendQueue();
+
+    SendQueue(const SendQueue&) = delete;
+    SendQueue& operator=(const SendQueue&) = delete;
+
+    // Producer: copies as much of [data, data + len) as fits and returns the
+    // byte count. Taking all of it ends a message for the latency counters.
+    size_t push(const char* data, size_t len);
+
+    // Bytes waiting to be sent
+    size_t depth() const;
+
+    // Waits until everything pushed has been sent (or the socket failed),
+    // then stops the sender thread. Called by the destructor too.
+    void close();
+
+    // Valid after close()
+    const Stats& getStats() const { return stats; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void senderLoop();
+
+    NetSocket sock;
+    std::vector<char> ring;
+    size_t mask;
+    std::atomic<uint64_t> head{0};  // written by the producer
+    std::atomic<uint64_t> tail{0};  // sent by the consumer
+
+    // Message ends for the latency counters, a ring of their own; the
+    // producer skips the sample when it is full
+    struct Mark {
+        uint64_t end;
+        Clock::time_point pushed;
+    };
+    std::vector<Mark> marks;
+    std::atomic<uint64_t> markHead{0};
+    std::atomic<uint64_t> markTail{0};
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+    std::thread sender;
+    Stats stats;
+};
+
+#endif // SENDQUEUE_H
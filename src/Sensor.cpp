@@ -0,0 +1,86 @@
+#include "Sensor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+bool parseSensorShape(const std::string& name, SensorShape& shape)
+{
+    if (name == "square") shape = SensorShape::Square;
+    else if (name == "circle") shape = SensorShape::Circle;
+    else if (name == "los") shape = SensorShape::LineOfSight;
+    else return false;
+    return true;
+}
+
+const char* sensorShapeName(SensorShape shape)
+{
+    switch (shape) {
+    case SensorShape::Circle:      return "circle";
+    case SensorShape::LineOfSight: return "los";
+    default:                       return "square";
+    }
+}
+
+SensorFootprint::SensorFootprint(SensorShape shape, int range)
+    : shape(shape), range(std::max(range, 0))
+{
+    int r = this->range;
+    int side = 2 * r + 1;
+    // Circle: dr^2 + dc^2 < (range + 1/2)^2, i.e. <= range^2 + range
+    int radius2 = r * r + r;
+    spans.resize(side);
+    for (int dr = -r; dr <= r; dr++) {
+        int w = r;
+        if (shape != SensorShape::Square) {
+            while (w > 0 && dr * dr + w * w > radius2) w--;
+        }
+        spans[dr + r] = w;
+        cells += 2 * w + 1;
+    }
+    if (shape != SensorShape::LineOfSight) return;
+
+    // Rays in order of rings around the drone, so a cell's parent (the
+    // nearest cell of the line from the drone, one ring in) comes first
+    std::vector<int> index((size_t)side * side, -1);
+    for (int ring = 0; ring <= r; ring++) {
+        for (int dr = -ring; dr <= ring; dr++) {
+            for (int dc = -span(dr); dc <= span(dr); dc++) {
+                if (std::max(std::abs(dr), std::abs(dc)) != ring) continue;
+                int parent = -1;
+                if (ring > 0) {
+                    int pr = (int)std::lround(dr * (ring - 1) / (double)ring);
+                    int pc = (int)std::lround(dc * (ring - 1) / (double)ring);
+                    parent = index[(size_t)(pr + r) * side + (pc + r)];
+                }
+                index[(size_t)(dr + r) * side + (dc + r)] = (int)rays.size();
+                rays.push_back({dr, dc, parent});
+            }
+        }
+    }
+    clear.resize(rays.size());
+    rowWords = (side + 63) / 64 + 1;
+    visible.resize((size_t)side * rowWords);
+}
+
+void SensorFootprint::trace(const GridMap& map, int row, int col)
+{
+    int rows = map.getRows();
+    int cols = map.getCols();
+    baseWord = std::max(col - range, 0) >> 6;
+    std::fill(visible.begin(), visible.end(), 0);
+    for (size_t i = 0; i < rays.size(); i++) {
+        const Ray& ray = rays[i];
+        int r = row + ray.dr;
+        int c = col + ray.dc;
+        // Rays only move away from the drone, so one that leaves the map
+        // does not come back
+        if ((ray.parent >= 0 && !clear[ray.parent]) || r < 0 || r >= rows || c < 0 || c >= cols) {
+            clear[i] = 0;
+            continue;
+        }
+        visible[(size_t)(ray.dr + range) * rowWords + ((c >> 6) - baseWord)] |= 1ULL << (c & 63);
+        // The drone sees out of its own cell even if it has caught fire
+        clear[i] = ray.parent < 0 || !map.isFire(r, c);
+    }
+}
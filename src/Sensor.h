@@ -0,0 +1,62 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+#include "GridMap.h"
+
+// What the drone sees around it
+//  Square:      every cell within 'range' rows and columns (the original).
+//  Circle:      the cells whose centre lies within range + 1/2 of the drone.
+//  LineOfSight: the circle, less what burning cells hide: a fire cell is
+//               seen, the cells behind it are not.
+enum class SensorShape { Square, Circle, LineOfSight };
+
+// "square", "circle" or "los"; false for anything else
+bool parseSensorShape(const std::string& name, SensorShape& shape);
+const char* sensorShapeName(SensorShape shape);
+
+// A sensor footprint, precomputed once for its range: row dr of it (-range
+// to range) covers columns -span(dr)..span(dr) around the drone, so it is
+// applied one word of a bit layer at a time. Line of sight also keeps, for
+// every cell of the circle, the cell before it on the ray from the drone,
+// and trace() walks those rays ring by ring; a cell is seen if the cell
+// before it was seen and is not on fire.
+class SensorFootprint {
+public:
+    SensorFootprint(SensorShape shape = SensorShape::Square, int range = 2);
+
+    SensorShape getShape() const { return shape; }
+    int getRange() const { return range; }
+    bool occludes() const { return shape == SensorShape::LineOfSight; }
+    int span(int dr) const { return spans[dr + range]; }
+    int area() const { return cells; }      // cells of the footprint, unclipped
+
+    // Line of sight from (row, col) over the current fires; visibleWord()
+    // then gives the cells of row dr seen in word w of the map's layers.
+    // Only the words the footprint covers are kept.
+    void trace(const GridMap& map, int row, int col);
+    uint64_t visibleWord(int dr, int w) const {
+        return visible[(size_t)(dr + range) * rowWords + (w - baseWord)];
+    }
+
+private:
+    struct Ray {
+        int dr, dc;
+        int parent;     // index of the cell before it, -1 for the drone's own
+    };
+
+    SensorShape shape;
+    int range;
+    int cells = 0;
+    std::vector<int> spans;         // 2 * range + 1 half-widths
+    std::vector<Ray> rays;          // line of sight: circle cells, nearest ring first
+    std::vector<uint8_t> clear;     // trace scratch: ray seen and not on fire
+    std::vector<uint64_t> visible;  // trace result, rowWords words per footprint row
+    int rowWords = 0;
+    int baseWord = 0;               // map word of each row's first visible word
+};
+
+#endif // SENSOR_H
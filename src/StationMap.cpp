@@ -0,0 +1,92 @@
+#include "StationMap.h"
+
+StationMap::StationMap(int rows, int cols)
+    : rows(rows), cols(cols)
+{
+    tilesAcross = (cols + TILE - 1) / TILE;
+    int tilesDown = (rows + TILE - 1) / TILE;
+    words = (size_t)tilesAcross * tilesDown * TILE;
+    seen.reset(new std::atomic<uint64_t>[words]);
+    fire.reset(new std::atomic<uint64_t>[words]);
+    for (size_t i = 0; i < words; i++) {
+        seen[i].store(0, std::memory_order_relaxed);
+        fire[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::atomic<uint64_t>& StationMap::word(std::atomic<uint64_t>* layer, int r, int c) const
+{
+    size_t tile = (size_t)(r / TILE) * tilesAcross + (c / TILE);
+    return layer[tile * TILE + (r % TILE)];
+}
+
+// Most reports repeat what another drone already said: a plain load settles
+// those without the locked read-modify-write, and keeps the cache line
+// shared between the ingest threads
+bool StationMap::setBit(std::atomic<uint64_t>& w, uint64_t bit)
+{
+    if (w.load(std::memory_order_relaxed) & bit) return false;
+    return !(w.fetch_or(bit, std::memory_order_relaxed) & bit);
+}
+
+bool StationMap::markSeen(int r, int c)
+{
+    if (r < 0 || r >= rows || c < 0 || c >= cols) return false;
+    return setBit(word(seen.get(), r, c), 1ULL << (c % TILE));
+}
+
+bool StationMap::markFire(int r, int c)
+{
+    if (r < 0 || r >= rows || c < 0 || c >= cols) return false;
+    uint64_t bit = 1ULL << (c % TILE);
+    setBit(word(seen.get(), r, c), bit);
+    return setBit(word(fire.get(), r, c), bit);
+}
+
+bool StationMap::isSeen(int r, int c) const
+{
+    return (word(seen.get(), r, c).load(std::memory_order_relaxed) >> (c % TILE)) & 1;
+}
+
+bool StationMap::isFire(int r, int c) const
+{
+    return (word(fire.get(), r, c).load(std::memory_order_relaxed) >> (c % TILE)) & 1;
+}
+
+uint64_t StationMap::count(const std::atomic<uint64_t>* layer) const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; i++) {
+        total += __builtin_popcountll(layer[i].load(std::memory_order_relaxed));
+    }
+    return total;
+}
+
+uint64_t StationMap::countSeen() const { return count(seen.get()); }
+uint64_t StationMap::countFire() const { return count(fire.get()); }
+
+void DroneCoverage::report(StationMap& map, int r, int c, bool onFire)
+{
+    int cols = map.getCols();
+    if (r < 0 || r >= map.getRows() || c < 0 || c >= cols) return;
+    if (seen.empty()) {
+        seen.assign(((size_t)map.getRows() * cols + 63) / 64, 0);
+        fire.assign(seen.size(), 0);
+    }
+    size_t cell = (size_t)r * cols + c;
+    uint64_t bit = 1ULL << (cell % 64);
+    if (!(seen[cell / 64] & bit)) {
+        seen[cell / 64] |= bit;
+        cells++;
+    }
+    if (onFire) {
+        // A drone repeats a burning cell in every scan that covers it
+        if (!(fire[cell / 64] & bit)) {
+            fire[cell / 64] |= bit;
+            fires++;
+        }
+        firstFires += map.markFire(r, c);
+    } else {
+        firstCells += map.markSeen(r, c);
+    }
+}
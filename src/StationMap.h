@@ -0,0 +1,61 @@
+#ifndef STATIONMAP_H
+#define STATIONMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The base station's picture of the whole map, written by many ingest
+// threads at once. Cells are kept as two bit layers (seen, fire) split into
+// 64x64 tiles: each tile row is one 64-bit word, and a tile's words are
+// contiguous, so drones working different areas touch different cache
+// lines. Updates are atomic fetch_or on a word - no locks, and the return
+// value tells the caller whether it was the first to report the cell.
+class StationMap {
+public:
+    StationMap(int rows, int cols);
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+
+    // The cell was seen clear / on fire. Out-of-range cells are ignored.
+    // Returns true if this call is the first to set the bit.
+    bool markSeen(int r, int c);
+    bool markFire(int r, int c);
+
+    bool isSeen(int r, int c) const;
+    bool isFire(int r, int c) const;
+
+    // Totals by popcount; exact once writers are done
+    uint64_t countSeen() const;
+    uint64_t countFire() const;
+
+private:
+    static const int TILE = 64;
+
+    static bool setBit(std::atomic<uint64_t>& w, uint64_t bit);
+    std::atomic<uint64_t>& word(std::atomic<uint64_t>* layer, int r, int c) const;
+    uint64_t count(const std::atomic<uint64_t>* layer) const;
+
+    int rows, cols;
+    int tilesAcross;
+    size_t words;
+    std::unique_ptr<std::atomic<uint64_t>[]> seen;
+    std::unique_ptr<std::atomic<uint64_t>[]> fire;
+};
+
+// What one drone has reported, kept by the thread that owns its connection
+struct DroneCoverage {
+    std::vector<uint64_t> seen;   // row-major bit per cell this drone saw
+    std::vector<uint64_t> fire;   // ... and per cell it reported on fire
+    uint64_t cells = 0;           // distinct cells it reported seen
+    uint64_t fires = 0;           // distinct fire cells it reported
+    uint64_t firstCells = 0;      // cells no drone had reported before it
+    uint64_t firstFires = 0;
+
+    // Records a report of (r, c) from this drone
+    void report(StationMap& map, int r, int c, bool onFire);
+};
+
+#endif // STATIONMAP_H
@@ -0,0 +1,192 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out += (char)(value | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = (uint8_t)*p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void TelemetryEncoder::window(std::string& out, uint64_t timeMs, int top, int left,
+                              int rows, int cols, const uint8_t* cells)
+{
+    payload.clear();
+    payload += (char)FrameType::Window;
+    putVarint(payload, timeMs - lastTime);
+    putVarint(payload, zigzag((int64_t)top - lastTop));
+    putVarint(payload, zigzag((int64_t)left - lastLeft));
+    putVarint(payload, (uint64_t)rows);
+    putVarint(payload, (uint64_t)cols);
+    lastTime = timeMs;
+    lastTop = top;
+    lastLeft = left;
+
+    size_t count = (size_t)rows * cols;
+    size_t i = 0;
+    while (i < count) {
+        uint8_t state = cells[i];
+        size_t run = 1;
+        while (i + run < count && cells[i + run] == state) run++;
+        putVarint(payload, (uint64_t)run << 2 | state);
+        i += run;
+    }
+
+    putVarint(out, payload.size());
+    out += payload;
+}
+
+void TelemetryEncoder::end(std::string& out)
+{
+    putVarint(out, 1);
+    out += (char)FrameType::End;
+}
+
+long TelemetryDecoder::decode(const char* data, size_t len, TelemetryFrame& frame)
+{
+    const char* p = data;
+    const char* bufferEnd = data + len;
+    uint64_t length;
+    if (!getVarint(p, bufferEnd, length)) {
+        // A varint longer than 10 bytes is corrupt rather than incomplete
+        return len >= 10 ? -1 : 0;
+    }
+    if (length == 0 || length > TELEMETRY_MAX_FRAME) return -1;
+    if ((uint64_t)(bufferEnd - p) < length) return 0;
+    const char* end = p + length;
+    long used = (long)(end - data);
+
+    frame.type = (FrameType)(uint8_t)*p++;
+    if (frame.type != FrameType::Window) return used;
+
+    uint64_t time, top, left, rows, cols;
+    if (!getVarint(p, end, time) || !getVarint(p, end, top) || !getVarint(p, end, left) ||
+        !getVarint(p, end, rows) || !getVarint(p, end, cols)) {
+        return -1;
+    }
+    // Each side on its own first, so the product cannot wrap
+    if (rows > TELEMETRY_MAX_FRAME || cols > TELEMETRY_MAX_FRAME || rows * cols > TELEMETRY_MAX_FRAME) return -1;
+    int64_t windowTop = lastTop + unzigzag(top);
+    int64_t windowLeft = lastLeft + unzigzag(left);
+    if (windowTop < INT32_MIN || windowTop > INT32_MAX || windowLeft < INT32_MIN || windowLeft > INT32_MAX) {
+        return -1;
+    }
+    if (mapRows > 0 && (windowTop < 0 || windowLeft < 0 || windowTop + (int64_t)rows > mapRows ||
+                        windowLeft + (int64_t)cols > mapCols)) {
+        return -1;
+    }
+    lastTime += time;
+    lastTop = (int)windowTop;
+    lastLeft = (int)windowLeft;
+    frame.timeMs = lastTime;
+    frame.top = lastTop;
+    frame.left = lastLeft;
+    frame.rows = (int)rows;
+    frame.cols = (int)cols;
+
+    size_t count = (size_t)(rows * cols);
+    frame.cells.resize(count);
+    size_t i = 0;
+    while (i < count) {
+        uint64_t run;
+        if (!getVarint(p, end, run)) return -1;
+        uint64_t n = run >> 2;
+        if (n == 0 || n > count - i) return -1;
+        std::fill(frame.cells.begin() + i, frame.cells.begin() + i + n, (uint8_t)(run & 3));
+        i += n;
+    }
+    return p == end ? used : -1;
+}
+
+TelemetryTracker::TelemetryTracker(int rows, int cols)
+    : wordsPerRow((cols + 63) / 64),
+      reportedSeen((size_t)rows * wordsPerRow, 0),
+      reportedFire((size_t)rows * wordsPerRow, 0) {}
+
+void TelemetryTracker::scan(const GridMap& map, const DiscoveredLayer& discovered,
+                            int scanTop, int scanLeft, int scanBottom, int scanRight,
+                            uint64_t scanTime, std::string& out)
+{
+    fresh.clear();
+    int newTop = scanBottom + 1, newLeft = scanRight + 1, newBottom = -1, newRight = -1;
+    int w0 = scanLeft >> 6, w1 = scanRight >> 6;
+    for (int r = scanTop; r <= scanBottom; r++) {
+        const uint64_t* seenRow = discovered.row(r);
+        const uint64_t* fireRow = map.fireRow(r);
+        uint64_t* sentSeen = reportedSeen.data() + (size_t)r * wordsPerRow;
+        uint64_t* sentFire = reportedFire.data() + (size_t)r * wordsPerRow;
+        for (int w = w0; w <= w1; w++) {
+            uint64_t seen = seenRow[w] & bitRange(w == w0 ? scanLeft & 63 : 0, w == w1 ? scanRight & 63 : 63);
+            uint64_t fire = fireRow[w] & seen;
+            // Seen for the first time, or burning since it was reported
+            uint64_t changed = (seen & ~sentSeen[w]) | (fire & ~sentFire[w]);
+            if (!changed) continue;
+            sentSeen[w] |= changed;
+            sentFire[w] |= fire & changed;
+            for (uint64_t bits = changed; bits; bits &= bits - 1) {
+                int c = w * 64 + __builtin_ctzll(bits);
+                fresh.push_back({r, c, (uint8_t)(CELL_DISCOVERED | ((fire >> (c & 63)) & 1 ? CELL_FIRE : 0))});
+                newLeft = std::min(newLeft, c);
+                newRight = std::max(newRight, c);
+            }
+            newTop = std::min(newTop, r);
+            newBottom = std::max(newBottom, r);
+        }
+    }
+    if (fresh.empty()) return;
+
+    // Share the pending window while the merged box stays mostly changes;
+    // the empty cells around them cost a run each at most
+    if (!pending.empty()) {
+        long mergedArea = (long)(std::max(bottom, newBottom) - std::min(top, newTop) + 1) *
+                          (std::max(right, newRight) - std::min(left, newLeft) + 1);
+        if (mergedArea > 4 * (long)(pending.size() + fresh.size()) + 16) {
+            flush(out);
+        }
+    }
+    if (pending.empty()) {
+        top = newTop;
+        left = newLeft;
+        bottom = newBottom;
+        right = newRight;
+    } else {
+        top = std::min(top, newTop);
+        left = std::min(left, newLeft);
+        bottom = std::max(bottom, newBottom);
+        right = std::max(right, newRight);
+    }
+    pending.insert(pending.end(), fresh.begin(), fresh.end());
+    timeMs = scanTime;
+}
+
+void TelemetryTracker::flush(std::string& out)
+{
+    if (pending.empty()) return;
+    int windowRows = bottom - top + 1, windowCols = right - left + 1;
+    cells.assign((size_t)windowRows * windowCols, 0);
+    for (const Change& change : pending) {
+        cells[(size_t)(change.row - top) * windowCols + (change.col - left)] = change.state;
+    }
+    encoder.window(out, timeMs, top, left, windowRows, windowCols, cells.data());
+    pending.clear();
+}
+
+void TelemetryTracker::end(std::string& out)
+{
+    flush(out);
+    encoder.end(out);
+}
@@ -0,0 +1,129 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "GridMap.h"
+#include "Coverage.h"
+
+// Binary drone -> station telemetry, negotiated in place of the text
+// protocol ("FIRE r c" / "END"). The drone opens with the text line
+// "HELLO <version> <droneId> <rows> <cols>" (version 0 if it only speaks
+// text); the station answers "HELLO <version>" with the version both sides
+// speak, 0 meaning "stay on text". A drone that got the answer in time
+// confirms it with "BINARY <version>"; the station switches to frames only
+// then, so a late answer leaves both sides on text. After that the drone
+// sends frames:
+//
+//   varint length | u8 type | payload (length - 1 bytes)
+//
+// Unknown types can be skipped by their length. Integers are LEB128
+// varints; signed values are zigzag-encoded first.
+//
+//   Window: varint time delta (ms since the previous frame), zigzag top and
+//           left (delta from the previous window's corner), varint rows and
+//           cols, then run-length coded cell states in row-major order:
+//           varint (runLength << 2 | state) until rows * cols cells are
+//           covered. A state has CELL_DISCOVERED and CELL_FIRE bits; a cell
+//           without CELL_DISCOVERED carries no news.
+//   End:    the drone is done.
+//
+// TelemetryTracker only puts cells in a window whose state changed since
+// the station last heard about them, so a window is a delta of the map.
+const int TELEMETRY_VERSION = 1;
+// Frames above this size, or windows of more cells, are treated as corrupt
+// input
+const uint64_t TELEMETRY_MAX_FRAME = 1 << 24;
+
+const uint8_t CELL_DISCOVERED = 1;
+const uint8_t CELL_FIRE = 2;
+
+enum class FrameType : uint8_t { Window = 1, End = 2 };
+
+// Signed values as varints: small magnitudes of either sign stay short
+inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+void putVarint(std::string& out, uint64_t value);
+// Reads a varint at 'p' and advances it; false if it runs past 'end'
+bool getVarint(const char*& p, const char* end, uint64_t& value);
+
+// Writes frames for one connection; remembers the previous corner and time
+// that the next frame is coded against
+class TelemetryEncoder {
+public:
+    // A rows x cols window with its top-left corner at (top, left), seen at
+    // 'timeMs'. 'cells' holds the state of every cell, row-major.
+    void window(std::string& out, uint64_t timeMs, int top, int left,
+                int rows, int cols, const uint8_t* cells);
+    void end(std::string& out);
+
+private:
+    std::string payload;
+    int lastTop = 0, lastLeft = 0;
+    uint64_t lastTime = 0;
+};
+
+// Turns perception updates into window frames. Remembers what it has
+// reported for every cell and sends only changes; the changes of
+// consecutive scans that sit close together share one window until flush().
+// What was reported is kept as bit layers laid out like the map's, so a
+// scan compares a word of cells at a time and only visits the changes.
+class TelemetryTracker {
+public:
+    TelemetryTracker(int rows, int cols);
+
+    // The drone looked at [top, bottom] x [left, right] at 'timeMs'. Appends a
+    // frame to 'out' when the new changes do not fit the pending window.
+    void scan(const GridMap& map, const DiscoveredLayer& discovered,
+              int top, int left, int bottom, int right, uint64_t timeMs, std::string& out);
+    // Appends the pending window, if any
+    void flush(std::string& out);
+    // Flushes and appends the End frame
+    void end(std::string& out);
+
+private:
+    struct Change {
+        int row, col;
+        uint8_t state;
+    };
+
+    int wordsPerRow;
+    std::vector<uint64_t> reportedSeen;     // sent as discovered
+    std::vector<uint64_t> reportedFire;     // sent as burning
+    std::vector<Change> pending;
+    std::vector<Change> fresh;
+    int top = 0, left = 0, bottom = -1, right = -1;     // pending bounds
+    uint64_t timeMs = 0;
+    std::vector<uint8_t> cells;
+    TelemetryEncoder encoder;
+};
+
+struct TelemetryFrame {
+    FrameType type;
+    uint64_t timeMs = 0;
+    int top = 0, left = 0, rows = 0, cols = 0;
+    std::vector<uint8_t> cells;     // Window: rows * cols states
+};
+
+// Reads the frames of one connection
+class TelemetryDecoder {
+public:
+    // Decodes the frame at the start of [data, data + len). Returns the bytes
+    // it takes up, 0 if the frame is not complete yet, or -1 if the input is
+    // malformed. Frames of unknown type are consumed and returned with a
+    // type outside FrameType.
+    long decode(const char* data, size_t len, TelemetryFrame& frame);
+    // Windows must then lie inside a rows x cols grid; others are malformed
+    void setBounds(int rows, int cols) { mapRows = rows; mapCols = cols; }
+
+private:
+    int mapRows = 0, mapCols = 0;   // 0 = not checked
+    int lastTop = 0, lastLeft = 0;
+    uint64_t lastTime = 0;
+};
+
+#endif // TELEMETRY_H
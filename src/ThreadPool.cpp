@@ -0,0 +1,118 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+    : job(nullptr), jobGeneration(0), remaining(0), busyWorkers(0), stopping(false)
+{
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) threadCount = 1;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    // Worker 0 is whichever thread calls parallelFor
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+int ThreadPool::size() const {
+    return (int)queues.size();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body) {
+    if (count <= 0) return;
+    int workers = size();
+    if (workers == 1 || count == 1) {
+        for (int i = 0; i < count; i++) body(i);
+        return;
+    }
+
+    // Deal out contiguous slices, one per worker
+    for (int w = 0; w < workers; w++) {
+        int begin = (int)((long long)count * w / workers);
+        int end   = (int)((long long)count * (w + 1) / workers);
+        std::lock_guard<std::mutex> guard(queues[w]->lock);
+        for (int i = begin; i < end; i++) queues[w]->tasks.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        job = &body;
+        remaining.store(count);
+        busyWorkers = workers - 1;
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+
+    runTasks(0);
+
+    // Wait until every task has run and every worker has left runTasks,
+    // so 'body' can safely go out of scope.
+    std::unique_lock<std::mutex> lock(jobLock);
+    jobDone.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int id) {
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(jobLock);
+            jobReady.wait(lock, [&] { return stopping || jobGeneration != seen; });
+            if (stopping) return;
+            seen = jobGeneration;
+        }
+        runTasks(id);
+        {
+            std::lock_guard<std::mutex> guard(jobLock);
+            busyWorkers--;
+        }
+        jobDone.notify_all();
+    }
+}
+
+void ThreadPool::runTasks(int id) {
+    int task;
+    while (remaining.load() > 0) {
+        if (popOwn(id, task) || steal(id, task)) {
+            (*job)(task);
+            remaining.fetch_sub(1);
+        } else {
+            // Everything is claimed; the last tasks are still running elsewhere
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool ThreadPool::popOwn(int id, int& task) {
+    Queue& q = *queues[id];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) return false;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(int id, int& task) {
+    int workers = size();
+    for (int i = 1; i < workers; i++) {
+        Queue& q = *queues[(id + i) % workers];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) continue;
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
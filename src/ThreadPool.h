@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool for data-parallel loops.
+//  - parallelFor hands each worker a contiguous slice of the index range;
+//    a worker that runs out pops indices from the far end of another
+//    worker's slice (work stealing), so uneven tasks still balance.
+//  - The calling thread takes part as worker 0, so ThreadPool(1) starts no
+//    threads and runs everything inline.
+class ThreadPool {
+public:
+    // threads <= 0 means one per hardware thread
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const;
+
+    // Runs body(i) for every i in [0, count) and returns when all are done.
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(int id);
+    void runTasks(int id);
+    bool popOwn(int id, int& task);
+    bool steal(int id, int& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex jobLock;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const std::function<void(int)>* job;
+    unsigned long jobGeneration;
+    std::atomic<int> remaining;
+    int busyWorkers;
+    bool stopping;
+};
+
+#endif // THREADPOOL_H